@@ -0,0 +1,43 @@
+/*
+ * boot_pipeline.h
+ *
+ * Boot work as a graph of named stages.  Each stage lists the stages it
+ * needs finished first; run() starts every stage as soon as those are done
+ * and logs how long each one took once they all are.
+ */
+
+#ifndef __BOOT_PIPELINE_H__
+#define __BOOT_PIPELINE_H__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+
+class boot_pipeline {
+  struct stage {
+    std::string name;
+    std::vector<size_t> after;
+    std::function<void()> work;
+    double msecs;
+  };
+
+  std::string _name;
+  std::vector<stage> _stages;
+
+public:
+  explicit boot_pipeline(const std::string &name) : _name(name) {}
+
+  boot_pipeline(const boot_pipeline &p) = delete;
+  const boot_pipeline &operator=(const boot_pipeline &p) = delete;
+
+  /*
+   * Stages may only wait on stages added before them, which keeps the
+   * graph acyclic.  The returned handle is what later stages wait on.
+   */
+  size_t add(const std::string &name, std::initializer_list<size_t> after, std::function<void()> work);
+
+  void run(void);
+};
+
+#endif /* __BOOT_PIPELINE_H__ */
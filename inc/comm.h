@@ -11,7 +11,9 @@
 #ifndef __COMM_H__
 #define __COMM_H__
 
+#include <string>
 #include <type_traits>
+#include <vector>
 #include "bitmask.h"
 
 #define NUM_RESERVED_DESCS	8
@@ -35,11 +37,58 @@ ENABLE_BITMASK_OPERATORS(CommTarget);
 void	perform_act(const char *orig, struct char_data *ch, struct obj_data *obj, const void *vict_obj, const struct char_data *to);
 void	act(const char *str, int hide_invisible, struct char_data *ch, struct obj_data *obj, const void *vict_obj, CommTarget type);
 
+/*
+ * An act() string split up once into plain text and $-codes, so sending
+ * it only has to fill in the codes for each viewer.
+ */
+struct act_token {
+  char code;			/* the $-code, or '\0' for plain text	*/
+  size_t start, len;		/* the plain text, within act_template::text */
+};
+
+struct act_template {
+  std::string source;		/* what it was compiled from		*/
+  std::string text;		/* all the plain text, run together	*/
+  std::vector<act_token> tokens;
+  bool names_ch = false;	/* has a $n, so 'someone' to some	*/
+  bool per_listener = false;	/* has other codes that vary by viewer	*/
+  bool pinned = false;		/* precompiled at boot; never dropped	*/
+};
+
+void	precompile_act(const char *str);
+
+/*
+ * One act() message for many listeners, such as a gossip.  Each way the
+ * line can read (whether they can see ch, colour on or off) is worked out
+ * once and then copied to everyone it suits.  The sender decides who
+ * hears it and calls send() for each of them; with 'color', listeners
+ * with colour on get the line wrapped in it and KNRM.
+ */
+class act_broadcast {
+  struct char_data *_ch;
+  struct obj_data *_obj;
+  const void *_vict_obj;
+  const char *_color;
+
+  act_template _template;
+  std::string _text[2][2];	/* [can see ch][colour]			*/
+  bool _rendered[2][2] = { { false, false }, { false, false } };
+
+  void render(const struct char_data *to, bool color, std::string &txt) const;
+
+public:
+  act_broadcast(const char *str, struct char_data *ch, struct obj_data *obj,
+		const void *vict_obj, const char *color = NULL);
+
+  void send(const struct char_data *to);
+};
+
 /* I/O functions */
 void	write_to_q(const char *txt, struct txt_q *queue, int aliased);
 int	write_to_descriptor(socket_t desc, const char *txt);
 size_t	write_to_output(struct descriptor_data *d, const char *txt, ...) __attribute__ ((format (printf, 2, 3)));
 size_t	vwrite_to_output(struct descriptor_data *d, const char *format, va_list args);
+size_t	write_text_to_output(struct descriptor_data *d, const char *txt, size_t len);
 void	string_add(struct descriptor_data *d, char *str);
 void	string_write(struct descriptor_data *d, char **txt, size_t len, long mailto, void *data);
 
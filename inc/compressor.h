@@ -0,0 +1,55 @@
+/*
+ * compressor.h
+ *
+ * MCCP v2 (TELOPT_COMPRESS2) output compression.  Each compressing
+ * descriptor has its own zlib stream, and a small pool of worker threads
+ * runs deflate() so that game_loop() only hands over filled output
+ * segments and picks up the compressed bytes later.
+ */
+
+#ifndef __COMPRESSOR_H__
+#define __COMPRESSOR_H__
+
+#include <memory>
+#include <string>
+
+class out_chain;
+struct compressor;
+
+void init_compressors(int threads);
+void shutdown_compressors(void);
+
+/* A new zlib stream whose output is meant for d. */
+std::shared_ptr<struct compressor> start_compression(struct descriptor_data *d);
+
+/*
+ * The descriptor is going away.  Anything still being compressed for it
+ * is thrown away when it turns up.
+ */
+void end_compression(std::shared_ptr<struct compressor> &c);
+
+/*
+ * The descriptor is closing while its socket still works.  Waits for the
+ * workers to finish what was handed over, and gives back all of it that
+ * hasn't been collected, followed by the end of the zlib stream.  Then
+ * the stream is gone, as with end_compression().
+ */
+void finish_compression(std::shared_ptr<struct compressor> &c, std::string &bytes);
+
+/* Takes all of 'text' (leaving it empty) to be compressed, in order. */
+void compress_output(const std::shared_ptr<struct compressor> &c, out_chain &text);
+
+/* Give the workers up to 'msec' milliseconds to finish what they have. */
+void wait_for_compressors(int msec);
+
+/*
+ * Non-blocking; fetches compressed bytes that are ready, and who they are
+ * for.  The descriptor is NULL if it has gone since.
+ */
+bool collect_compressed_output(struct descriptor_data **d, std::string &bytes);
+
+/* Running totals, for 'show stats'. */
+extern unsigned long long compress_bytes_in, compress_bytes_out;
+extern double compress_cpu_msec;
+
+#endif /* __COMPRESSOR_H__ */
@@ -33,6 +33,9 @@
 /* Define if the system is capable of using crypt() to encrypt.  */
 #define CIRCLE_CRYPT 1
 
+/* Define if the system has the reentrant crypt_r().  */
+#define HAVE_CRYPT_R 1
+
 /* TODO: efine if we don't have proper support for the system's crypt().  */
 #undef HAVE_UNSAFE_CRYPT
 
@@ -132,6 +135,9 @@
 /* Define if you have the <strings.h> header file.  */
 #define HAVE_STRINGS_H 1
 
+/* Define if you have the <sys/epoll.h> header file.  */
+#define HAVE_SYS_EPOLL_H 1
+
 /* Define if you have the <sys/fcntl.h> header file.  */
 #define HAVE_SYS_FCNTL_H 1
 
@@ -22,11 +22,14 @@ extern int idle_void;
 extern int idle_rent_time;
 extern int idle_max_level;
 extern bool dts_are_dumps;
+extern bool idle_empty_zones;
+extern int zone_reset_budget;
 extern bool load_into_inventory;
 extern const std::string OK;
 extern const std::string NOPERSON;
 extern const std::string NOEFFECT;
-extern bool track_through_doorsextern ;
+extern bool track_through_doors;
+extern int route_cache_size;
 extern int immort_level_ok;
 extern bool free_rent;
 extern int max_obj_save;
@@ -50,6 +53,11 @@ extern int max_filesize;
 extern int max_bad_pws;
 extern bool siteok_everyone;
 extern bool nameserver_is_slow;
+extern int resolver_threads;
+extern int resolver_timeout;
+extern int crypt_threads;
+extern int compress_threads;
+extern int compress_wait_msec;
 extern const std::string MENU;
 extern const std::string WELC_MESSG;
 extern const std::string START_MESSG;
@@ -67,6 +67,8 @@
 #define OBJ_PREFIX	LIB_WORLD "obj" SLASH	/* object prototypes	*/
 #define ZON_PREFIX	LIB_WORLD "zon" SLASH	/* zon defs & command tables */
 #define SHP_PREFIX	LIB_WORLD "shp" SLASH	/* shop definitions	*/
+#define SNAPSHOT_FILE	LIB_WORLD "snapshot"	/* binary copy of the world */
+#define MSNAPSHOT_FILE	LIB_WORLD "snapshot.mini" /* ... for mini-mud-mode */
 #define HLP_PREFIX	LIB_TEXT "help" SLASH	/* for HELP <keyword>	*/
 
 #define CREDITS_FILE	LIB_TEXT "credits" /* for the 'credits' command	*/
@@ -100,6 +102,7 @@ void	boot_db(void);
 void	destroy_db(void);
 int	create_entry(const char *name);
 void	zone_update(void);
+void	continue_zone_resets(void);
 char	*fread_string(FILE *fl, const char *error);
 long	get_id_by_name(const char *name);
 std::string get_name_by_id(long id);
@@ -172,6 +175,8 @@ struct zone_data {
   
   int	reset_mode;         /* conditions for reset (see below)   */
   zone_vnum number;	    /* virtual number of this zone	  */
+  int players = 0;	    /* mortals playing here right now     */
+  unsigned long reset_ticket = 0; /* place in the reset queue, or 0   */
 
   std::vector<reset_com> cmd;   /* command table for reset	          */  
   /*
@@ -184,22 +189,6 @@ struct zone_data {
 
 
 
-/* for queueing zones for update   */
-struct reset_q_element {
-   zone_rnum zone_to_reset;            /* ref to zone_data */
-   struct reset_q_element *next;
-};
-
-
-
-/* structure for the update queue     */
-struct reset_q_type {
-   struct reset_q_element *head;
-   struct reset_q_element *tail;
-};
-
-
-
 struct player_index_element {
    std::string	name;
    long id;
@@ -220,7 +209,7 @@ extern std::vector<room_data> world;
 extern std::vector<zone_data> zone_table;
 
 extern struct descriptor_data *descriptor_list;
-extern std::list<char_data *> character_list;
+extern char_list character_list;
 extern struct player_special_data dummy_mob;
 
 extern std::vector<index_data> mob_index;
@@ -228,7 +217,7 @@ extern std::vector<char_data> mob_proto;
 
 extern std::vector<index_data> obj_index;
 extern std::vector<obj_data> obj_proto;
-extern std::list<obj_data *> object_list;
+extern obj_list object_list;
 
 extern std::vector<help_index_element> help_table;
 extern struct time_info_data time_info;
@@ -256,7 +245,7 @@ extern room_rnum donation_room_3;  /* uncomment if needed! */
 
 extern struct spell_info_type spell_info[];
 extern int max_filesize;
-extern int track_through_doors;
+extern bool track_through_doors;
 extern int tunnel_size;
 
 extern FILE *player_fl;
@@ -264,7 +253,9 @@ extern struct attack_hit_type attack_hit_text[];
 extern time_t boot_time;
 extern int circle_shutdown, circle_reboot;
 extern int circle_restrict;
-extern int buf_switches, buf_largecount, buf_overflows;
+extern int buf_overflows;
+extern unsigned long loop_passes, loop_overruns;
+extern long loop_longest;
 extern int mini_mud;
 
 extern std::vector<message_list> fight_messages;
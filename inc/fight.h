@@ -4,7 +4,7 @@
 #include <list>
 
 // extern data
-extern struct std::list<char_data *> combat_list;
+extern char_list combat_list;
 
 /* External procedures */
 int ok_damage_shopkeeper(struct char_data *ch, struct char_data *victim);
@@ -5,10 +5,12 @@
 #include <future>
 #include <thread>
 #include <fstream>
+#include <iterator>
 #include <algorithm>
 #include <functional>
 
 #include "db.h"
+#include "task_pool.h"
 
 template<class T>
 class future_parse {
@@ -35,13 +37,31 @@ class future_parse {
     }
     idx.close();
 
-    std::for_each(indexes.begin(), indexes.end(), [this,&items](std::string &s) { this->parse_single_idx(s, items); });
+    // one task per file; stitched back together in index order below
+    std::vector<std::future<std::vector<T>>> files;
+    for (const auto &name : indexes) {
+      files.push_back(boot_pool().run([this, name] {
+        std::vector<T> parsed;
+        this->parse_single_idx(name, parsed);
+        return parsed;
+      }));
+    }
+
+    for (auto &file : files) {
+      std::vector<T> parsed = file.get();
+      std::move(parsed.begin(), parsed.end(), std::back_inserter(items));
+    }
+    renumber(items);
 
-    promise.set_value(items);
+    promise.set_value(std::move(items));
   }
 
   virtual void parse_single_idx(const std::string &idx, std::vector<T> &items) noexcept = 0;
 
+  // files are parsed apart, so any rnum set by parse_single_idx() is only
+  // an index into its own file until this fixes it up.
+  virtual void renumber(std::vector<T> &items) noexcept {}
+
 protected:
   const std::string read(std::ifstream &f) const 
   {
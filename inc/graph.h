@@ -0,0 +1,12 @@
+#ifndef __GRAPH_H__
+#define __GRAPH_H__
+
+/* External procedures */
+int find_first_step(room_rnum src, room_rnum target);
+void hunt_victim(struct char_data *ch);
+
+/* Call when exits change, so remembered routes aren't used any more. */
+void routes_changed(void);
+void door_changed(void);
+
+#endif
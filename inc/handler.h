@@ -21,10 +21,16 @@
 void	affect_total(struct char_data *ch);
 void	affect_modify(struct char_data *ch, byte loc, sbyte mod, bitvector_t bitv, bool add);
 void	affect_to_char(struct char_data *ch, const affected_type &af);
-void	affect_remove(struct char_data *ch, affected_type &af);
+void	affect_remove(struct char_data *ch, struct char_affect &af);
 void	affect_from_char(struct char_data *ch, int type);
 bool	affected_by_spell(struct char_data *ch, int type);
 void	affect_join(struct char_data *ch, affected_type &af, bool add_dur, bool avg_dur, bool add_mod, bool avg_mod);
+int	affect_duration(const struct char_affect &af);
+void	hold_affects(struct char_data *ch);
+void	resume_affects(struct char_data *ch);
+
+extern affect_schedule affect_timers;
+extern unsigned long affect_hour;
 
 /* utility */
 const char *money_desc(int amount);
@@ -58,6 +64,7 @@ struct char_data *get_char_num(mob_rnum nr);
 
 void	char_from_room(struct char_data *ch);
 void	char_to_room(struct char_data *ch, room_rnum room);
+void	update_zone_players(struct char_data *ch);
 void	extract_char(struct char_data *ch);
 void	extract_char_final(struct char_data *ch);
 void	extract_pending_chars(void);
@@ -69,10 +76,10 @@ struct char_data *get_char_room_vis(struct char_data *ch, char *name, int *numbe
 struct char_data *get_char_world_vis(struct char_data *ch, char *name, int *number);
 
 struct obj_data *get_obj_in_list_num(int num, struct obj_data *list);
-struct obj_data *get_obj_in_list_num(int num, std::list<obj_data *> &list);
+struct obj_data *get_obj_in_list_num(int num, obj_list &list);
 struct obj_data *get_obj_num(obj_rnum nr);
 struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, struct obj_data *list);
-struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, std::list<obj_data *> &list);
+struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, obj_list &list);
 struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *num);
 struct obj_data *get_obj_in_equip_vis(struct char_data *ch, char *arg, int *number, struct obj_data *equipment[]);
 int              get_obj_pos_in_equip_vis(struct char_data *ch, char *arg, int *num, struct obj_data *equipment[]);
@@ -0,0 +1,25 @@
+/*
+ * hasher.h
+ *
+ * Password hashing for nanny(), done by a small pool of worker threads so
+ * that crypt() never stalls game_loop() while someone logs in.
+ */
+
+#ifndef __HASHER_H__
+#define __HASHER_H__
+
+#include <string>
+
+void init_hashers(int threads);
+void shutdown_hashers(void);
+
+/* Queue crypt(plain, salt); the returned ticket (never 0) identifies it. */
+unsigned long hash_password(const char *plain, const char *salt);
+
+/*
+ * Non-blocking; fetches one finished hash.  An empty hash means crypt()
+ * refused the input and must never be taken as a match.
+ */
+bool collect_password_hash(unsigned long *ticket, std::string &hash);
+
+#endif /* __HASHER_H__ */
@@ -18,6 +18,7 @@
 #define IS_MOVE(cmdnum) (cmd_info[cmdnum].command_pointer == do_move)
 
 void	command_interpreter(struct char_data *ch, char *argument);
+void	build_command_trie(void);
 int	search_block(char *arg, const char **list, int exact);
 char	lower( char c );
 char	*one_argument(char *argument, char *first_arg);
@@ -27,6 +28,7 @@ char	*two_arguments(char *argument, char *first_arg, char *second_arg);
 int	fill_word(char *argument);
 void	half_chop(char *string, char *arg1, char *arg2);
 void	nanny(struct descriptor_data *d, char *arg);
+void	check_password_hashes(void);
 int	is_abbrev(const char *arg1, const char *arg2);
 int	is_number(const char *str);
 int	find_command(const char *command);
@@ -14,6 +14,11 @@ class mob_future final : public future_parse<char_data>
   using future_parse::future_parse;
  private:
   void parse_single_idx(const std::string &idx, std::vector<char_data> &zones) noexcept final;
+  void renumber(std::vector<char_data> &items) noexcept final
+  {
+    for (size_t rnum = 0; rnum < items.size(); rnum++)
+      items[rnum].nr = rnum;
+  }
 
   void parse_simple_mob(std::ifstream &file, char_data &reading, int rnum) noexcept;
   void parse_enhanced_mob(std::ifstream &file, char_data &reading, int rnum) noexcept;
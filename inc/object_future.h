@@ -9,6 +9,11 @@ class object_future final : public future_parse<obj_data> {
   using future_parse::future_parse;
 private:
   void parse_single_idx(const std::string &idx, std::vector<obj_data> &rooms) noexcept final;
+  void renumber(std::vector<obj_data> &items) noexcept final
+  {
+    for (size_t rnum = 0; rnum < items.size(); rnum++)
+      items[rnum].item_number = rnum;
+  }
 public:
   object_future(bool mini = false) : future_parse(mini, OBJ_PREFIX) {}
 
@@ -0,0 +1,78 @@
+/*
+ * outbuf.h
+ *
+ * Output on its way to a descriptor, held as a chain of fixed-size
+ * segments from a slab pool.  Text is formatted straight into the last
+ * segment and written out of the chain with writev(); a short write only
+ * moves the front of the chain along, so nothing queued is copied again.
+ */
+
+#ifndef __OUTBUF_H__
+#define __OUTBUF_H__
+
+#include <cstdarg>
+#include <cstddef>
+
+#define OUT_SEGMENT_SIZE	2016	/* text per segment; 2K with header */
+
+struct out_segment {
+  struct out_segment *next;
+  size_t start, end;		/* the unsent text is data[start, end)	*/
+  char data[OUT_SEGMENT_SIZE];
+
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+};
+
+/* Gives back a list of segments handed out by out_chain::release(). */
+void free_segments(struct out_segment *list);
+
+
+class out_chain {
+  struct out_segment *_head = nullptr, *_tail = nullptr;
+  size_t _length = 0;
+
+  struct out_segment *add_segment(void);
+
+public:
+  out_chain() = default;
+  ~out_chain() { clear(); }
+
+  out_chain(const out_chain &c) = delete;
+  const out_chain &operator=(const out_chain &c) = delete;
+
+  bool empty(void) const { return (_length == 0); }
+  size_t length(void) const { return (_length); }
+
+  void append(const char *txt, size_t len);
+  void append(const char *txt);
+
+  /*
+   * Formats onto the end, at any length, and returns the number of bytes
+   * added.  Adds nothing and returns -1 if that would take the chain past
+   * 'limit' bytes.
+   */
+  int vformat(size_t limit, const char *format, va_list args);
+
+  /* Moves all of 'other' onto the end of this chain, leaving it empty. */
+  void splice(out_chain &other);
+
+  /* Appends the first 'len' bytes of this chain to 'dest'. */
+  void copy_to(out_chain &dest, size_t len) const;
+
+  /* Fills up to 'max' iovecs from the front; returns how many it used. */
+  int fill_iovecs(struct iovec *iov, int max) const;
+
+  /* Drops the first 'len' bytes, which have been sent. */
+  void consume(size_t len);
+
+  /*
+   * Hands over the segments themselves, oldest first, and leaves the
+   * chain empty.  They go back with free_segments().
+   */
+  struct out_segment *release(void);
+
+  void clear(void);
+};
+
+#endif /* __OUTBUF_H__ */
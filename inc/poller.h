@@ -0,0 +1,44 @@
+/*
+ * poller.h
+ *
+ * Readiness notification for the sockets driven by game_loop().
+ *
+ * A poller keeps a persistent registration for the mother socket and for
+ * every connected descriptor, so nothing has to be rebuilt per pass.  After
+ * wait() the readable()/writable()/exception() queries are O(1) lookups.
+ *
+ * Output interest is only armed while a descriptor holds output the kernel
+ * did not take (want_output() after process_output(), while d->output or
+ * d->wire is not empty); a socket that is not armed is assumed to be
+ * writable.
+ */
+
+#ifndef __POLLER_H__
+#define __POLLER_H__
+
+class poller {
+public:
+  virtual ~poller() = default;
+
+  /* The listening socket is level-triggered: one accept() per pass. */
+  virtual bool add_listener(socket_t s) = 0;
+  virtual bool add(socket_t s) = 0;
+  virtual void remove(socket_t s) = 0;
+
+  virtual void want_output(socket_t s, bool want) = 0;
+  /* process_input() hit EAGAIN; wait for the next input edge. */
+  virtual void input_drained(socket_t s) = 0;
+
+  /* NULL timeout blocks; returns < 0 on error with errno set. */
+  virtual int wait(struct timeval *timeout) = 0;
+
+  virtual bool readable(socket_t s) const = 0;
+  virtual bool writable(socket_t s) const = 0;
+  virtual bool exception(socket_t s) const = 0;
+
+  virtual const char *name(void) const = 0;
+};
+
+poller *create_poller(void);
+
+#endif /* __POLLER_H__ */
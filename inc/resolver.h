@@ -0,0 +1,25 @@
+/*
+ * resolver.h
+ *
+ * Reverse DNS lookups for new connections, done by a small pool of worker
+ * threads so that a slow nameserver never stalls game_loop().
+ */
+
+#ifndef __RESOLVER_H__
+#define __RESOLVER_H__
+
+#include <string>
+
+void init_resolver(int threads);
+void shutdown_resolver(void);
+
+/* Queue a lookup; the returned ticket (never 0) identifies the answer. */
+unsigned long resolve_host(const struct in_addr *addr);
+
+/*
+ * Non-blocking; fetches one finished lookup.  An empty name means the
+ * address has no name and the numeric form should stay.
+ */
+bool collect_resolved_host(unsigned long *ticket, std::string &name);
+
+#endif /* __RESOLVER_H__ */
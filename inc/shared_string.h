@@ -0,0 +1,68 @@
+/*
+ * shared_string.h
+ *
+ * Immutable, reference-counted text for the parts of mobiles and objects
+ * that come from their prototypes.  read_mobile() and read_object() copy
+ * the prototype, which now only copies references; an instance that is
+ * given text of its own gets a new string and leaves the prototype and
+ * its other instances alone.
+ */
+
+#ifndef __SHARED_STRING_H__
+#define __SHARED_STRING_H__
+
+#include <memory>
+#include <string>
+
+template<class T>
+class shared_value {
+  std::shared_ptr<T> _v;
+
+  /* Everything empty shares one value, so a fresh instance allocates nothing. */
+  static const std::shared_ptr<T> &blank(void)
+  {
+    static const std::shared_ptr<T> b = std::make_shared<T>();
+
+    return b;
+  }
+
+public:
+  shared_value() : _v(blank()) {}
+  shared_value(const T &v) : _v(std::make_shared<T>(v)) {}
+  shared_value(T &&v) : _v(std::make_shared<T>(std::move(v))) {}
+
+  const T &get(void) const { return *_v; }
+  operator const T &() const { return *_v; }
+  const T *operator->() const { return _v.get(); }
+
+  /* Copy on write: whoever else holds the old value keeps it unchanged. */
+  T &edit(void)
+  {
+    if (_v.use_count() > 1)
+      _v = std::make_shared<T>(*_v);
+    return *_v;
+  }
+};
+
+
+class shared_string : public shared_value<std::string> {
+public:
+  shared_string() {}
+  shared_string(const std::string &s) : shared_value<std::string>(s) {}
+  shared_string(std::string &&s) : shared_value<std::string>(std::move(s)) {}
+  shared_string(const char *s) : shared_value<std::string>(std::string(s)) {}
+
+  const std::string &str(void) const { return get(); }
+  const char *c_str(void) const { return get().c_str(); }
+  bool empty(void) const { return get().empty(); }
+  size_t size(void) const { return get().size(); }
+  size_t length(void) const { return get().length(); }
+  char operator[](size_t i) const { return get()[i]; }
+
+  bool operator==(const char *s) const { return get() == s; }
+  bool operator!=(const char *s) const { return get() != s; }
+  bool operator==(const std::string &s) const { return get() == s; }
+  bool operator!=(const std::string &s) const { return get() != s; }
+};
+
+#endif /* __SHARED_STRING_H__ */
@@ -0,0 +1,55 @@
+/*
+ * simulate.h
+ *
+ * The headless simulation mode (circle -b).  It boots the world, lets in
+ * some scripted players with no sockets behind them, and runs heartbeat()
+ * back to back, with a fixed seed, for as many pulses as asked.  Then it
+ * says how fast that went and where the time went.
+ */
+
+#ifndef __SIMULATE_H__
+#define __SIMULATE_H__
+
+#include <chrono>
+
+/* The parts of a pulse timed separately; the rest is counted as other. */
+enum sim_part {
+  SIM_COMMANDS,			/* the scripted players' commands	*/
+  SIM_ZONE_UPDATE,
+  SIM_ZONE_RESETS,		/* continue_zone_resets()		*/
+  SIM_MOBILE_ACTIVITY,
+  SIM_PERFORM_VIOLENCE,
+  SIM_POINT_UPDATE,		/* all the characters' hourly updates	*/
+  SIM_AFFECT_UPDATE,
+  SIM_EXTRACTIONS,		/* extract_pending_chars()		*/
+  NUM_SIM_PARTS
+};
+
+extern long sim_pulses;		/* 0 unless simulating			*/
+
+void simulate_game(long pulses, int players);
+void sim_record(int part, std::chrono::steady_clock::duration spent);
+
+/*
+ * Times the rest of the block it is declared in against 'part', when
+ * simulating; otherwise it costs a test of sim_pulses.
+ */
+class sim_stopwatch {
+  int _part;
+  std::chrono::steady_clock::time_point _start;
+
+public:
+  explicit sim_stopwatch(int part) : _part(part)
+  {
+    if (sim_pulses)
+      _start = std::chrono::steady_clock::now();
+  }
+
+  ~sim_stopwatch()
+  {
+    if (sim_pulses)
+      sim_record(_part, std::chrono::steady_clock::now() - _start);
+  }
+};
+
+#endif /* __SIMULATE_H__ */
@@ -0,0 +1,126 @@
+/*
+ * slab_pool.h
+ *
+ * Fixed-size allocation for the things the game makes and destroys all
+ * the time: characters, objects, and the nodes of the lists that hold
+ * them.  Each pool carves its slots out of large slabs and recycles them
+ * through a freelist, so a zone reset reuses what the last round of
+ * extractions gave back and live entities sit close together in memory.
+ *
+ * Pools are not locked.  Boot stages run side by side (see boot_db()),
+ * but the only ones that make characters, objects or list nodes are
+ * "houses" and "zone resets", and the stage graph runs those one after
+ * the other.  After boot only the game loop allocates and frees; output
+ * sent to the compressor threads comes back to it to be freed.  A new
+ * stage that loads objects or mobiles must be ordered against those two.
+ */
+
+#ifndef __SLAB_POOL_H__
+#define __SLAB_POOL_H__
+
+#include <new>
+#include <vector>
+#include <cstddef>
+
+class slab_pool {
+  struct free_slot {
+    free_slot *next;
+  };
+
+  const char *_name;
+  size_t _slot_size;
+  size_t _slots_per_slab;
+  free_slot *_free = nullptr;
+  std::vector<char *> _slabs;
+
+  unsigned long _in_use = 0, _peak = 0, _allocs = 0;
+
+  void grow(void);
+
+public:
+  slab_pool(const char *name, size_t size, size_t align);
+
+  slab_pool(const slab_pool &p) = delete;
+  const slab_pool &operator=(const slab_pool &p) = delete;
+
+  void *allocate(void)
+  {
+    if (!_free)
+      grow();
+
+    free_slot *slot = _free;
+    _free = slot->next;
+
+    if (++_in_use > _peak)
+      _peak = _in_use;
+    _allocs++;
+
+    return (slot);
+  }
+
+  void deallocate(void *p)
+  {
+    free_slot *slot = static_cast<free_slot *>(p);
+
+    slot->next = _free;
+    _free = slot;
+    _in_use--;
+  }
+
+  const char *name(void) const { return _name; }
+  size_t slot_size(void) const { return _slot_size; }
+  size_t slabs(void) const { return _slabs.size(); }
+  unsigned long in_use(void) const { return _in_use; }
+  unsigned long peak(void) const { return _peak; }
+  unsigned long allocs(void) const { return _allocs; }
+
+  /* Every pool ever made, in creation order, for 'show stats'. */
+  static const std::vector<slab_pool *> &all(void);
+};
+
+
+/*
+ * One pool per node size, shared by every list whose nodes are that big.
+ * Pools are never destroyed, so global lists can still give their nodes
+ * back while the program exits.
+ */
+template<size_t Size, size_t Align>
+slab_pool &node_pool(void)
+{
+  static slab_pool *pool = new slab_pool("list nodes", Size, Align);
+
+  return *pool;
+}
+
+
+/* An allocator for std::list that takes its nodes from node_pool<>. */
+template<class T>
+struct pool_allocator {
+  typedef T value_type;
+
+  pool_allocator() noexcept {}
+  template<class U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T *allocate(size_t n)
+  {
+    if (n != 1)
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    return static_cast<T *>(node_pool<sizeof(T), alignof(T)>().allocate());
+  }
+
+  void deallocate(T *p, size_t n) noexcept
+  {
+    if (n != 1)
+      ::operator delete(p);
+    else
+      node_pool<sizeof(T), alignof(T)>().deallocate(p);
+  }
+};
+
+template<class T, class U>
+bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) { return true; }
+
+template<class T, class U>
+bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) { return false; }
+
+#endif /* __SLAB_POOL_H__ */
@@ -0,0 +1,23 @@
+/*
+ * snapshot.h
+ *
+ * A binary copy of the tables boot_world() builds from the text world
+ * files, so a restart can skip parsing them.  The snapshot records the
+ * size and mtime of every index and world file it was built from and is
+ * ignored as soon as any of them changes.
+ */
+
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+/*
+ * Fills zone_table, world, obj_proto, mob_proto and (with_shops)
+ * shop_index, already renumbered.  Returns false, leaving the tables
+ * empty, if there is no usable snapshot.
+ */
+bool load_world_snapshot(bool mini, bool with_shops);
+
+/* Call once boot_world() has finished with the tables. */
+void save_world_snapshot(bool mini, bool with_shops);
+
+#endif /* __SNAPSHOT_H__ */
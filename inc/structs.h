@@ -12,14 +12,19 @@
 #define __STRUCTS_H__
 
 #include <list>
+#include <map>
 #include <vector>
 #include <algorithm>
 #include <array>
 #include <tuple>
 #include <string>
+#include <memory>
 
 #include "sysdep.h"
 #include "olc.h"
+#include "shared_string.h"
+#include "slab_pool.h"
+#include "outbuf.h"
 
 /*
  * Intended use of this macro is to allow external packages to work with
@@ -274,6 +279,7 @@
 #define CON_DELCNF1	 15	/* Delete confirmation 1		*/
 #define CON_DELCNF2	 16	/* Delete confirmation 2		*/
 #define CON_DISCONNECT	 17	/* In-game link loss (leave character)	*/
+#define CON_VERIFYING	 18	/* Waiting on the password hashers	*/
 
 /* Character equipment positions: used as index for char_data.equipment[] */
 /* NOTE: Don't confuse these constants with the ITEM_ bitvectors
@@ -500,10 +506,8 @@
 /* Variables for the output buffering system */
 #define MAX_SOCK_BUF            (12 * 1024) /* Size of kernel's sock buf   */
 #define MAX_PROMPT_LENGTH       96          /* Max length of prompt        */
-#define GARBAGE_SPACE		32          /* Space for **OVERFLOW** etc  */
-#define SMALL_BUFSIZE		1024        /* Static output buffer size   */
-/* Max amount of output that can be buffered */
-#define LARGE_BUFSIZE	   (MAX_SOCK_BUF - GARBAGE_SPACE - MAX_PROMPT_LENGTH)
+/* Max amount of output that can be buffered (see outbuf.h) */
+#define MAX_OUTPUT_SIZE         (256 * 1024)
 
 #define HISTORY_SIZE		5	/* Keep last 5 commands. */
 #define MAX_STRING_LENGTH	8192
@@ -629,6 +633,13 @@ struct obj_affected_type {
 };
 
 
+struct timer_event;		/* see timer_wheel.h */
+
+/* The lists characters and objects live on take their nodes from a pool. */
+typedef std::list<struct obj_data *, pool_allocator<struct obj_data *> > obj_list;
+typedef std::list<struct char_data *, pool_allocator<struct char_data *> > char_list;
+
+
 /* ================== Memory Structure for Objects ================== */
 struct obj_data {
   obj_rnum item_number;	/* Where in data-base			*/
@@ -638,12 +649,13 @@ struct obj_data {
   struct obj_flag_data obj_flags;/* Object information               */
   struct obj_affected_type affected[MAX_OBJ_AFFECT];  /* affects (make a list? or std::array<>?) */
 
-  std::string name;                    /* Title of object :get etc.        */
-  std::string description;	       /* When in room                     */
-  std::string short_description;       /* when worn/carry/in cont.         */
-  std::string action_description;      /* What to write when used          */
+  /* Shared with the prototype until something gives this object its own. */
+  shared_string name;                  /* Title of object :get etc.        */
+  shared_string description;	       /* When in room                     */
+  shared_string short_description;     /* when worn/carry/in cont.         */
+  shared_string action_description;    /* What to write when used          */
 
-  std::list<extra_descr_data> ex_description;
+  shared_value<std::list<extra_descr_data> > ex_description;
 
    struct char_data *carried_by;  /* Carried by :NULL in room/conta   */
    struct char_data *worn_by;	  /* Worn by?			      */
@@ -656,6 +668,11 @@ struct obj_data {
   // TODO: make object list a std::list, remove these. 
    struct obj_data *next_content; /* For 'contains' lists             */
 
+  obj_list::iterator room_pos; /* Our node in world[in_room].contents */
+  obj_list::iterator proto_pos; /* Our node in obj_index[item_number].objects */
+  unsigned long serial;        /* From read_object(); slots are reused, this isn't */
+  struct timer_event *tick;    /* Hourly decay, for corpses */
+
   // clean this sh*t up later
   obj_data() noexcept {
     clear();
@@ -672,30 +689,38 @@ struct obj_data {
       affected[i] = obj.affected[i];
     }
 
-    name = std::string(obj.name);
-    description = std::string(obj.description);
-    short_description = std::string(obj.short_description);
-    action_description = std::string(obj.action_description);
+    name = obj.name;
+    description = obj.description;
+    short_description = obj.short_description;
+    action_description = obj.action_description;
 
-    ex_description = obj.ex_description; // should copy
+    ex_description = obj.ex_description;
     in_obj = contains = next_content = nullptr; // for now
     carried_by = worn_by =  nullptr;
     worn_on = obj.worn_on;
+    serial = 0;
+    tick = nullptr;
   }
 
   void clear() {
     in_obj = contains = next_content =  nullptr;
     worn_by = carried_by = nullptr;
-    ex_description.clear();
-    name = "";
-    description = "";
-    short_description = "";
-    action_description = "";
+    serial = 0;
+    tick = nullptr;
+    ex_description = shared_value<std::list<extra_descr_data> >();
+    name = shared_string();
+    description = shared_string();
+    short_description = shared_string();
+    action_description = shared_string();
 
     in_room = -1;
     obj_flags.clear();
     std::for_each(affected, affected +  MAX_OBJ_AFFECT, [](obj_affected_type &a) { a.clear(); });
   }
+
+  /* Instances come out of a slab_pool; see db.c. */
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
 };
 /* ======================================================================= */
 
@@ -766,8 +791,8 @@ struct room_data {
   byte light;                  /* Number of lightsources in room     */
   SPECIAL(*func);
   
-  std::list<obj_data *> contents;
-  std::list<char_data *> people;    /* List of NPC / PC in room           */
+  obj_list contents;
+  char_list people;    /* List of NPC / PC in room           */
 };
 /* ====================================================================== */
 
@@ -812,10 +837,10 @@ struct time_data {
 /* general player-related info, usually PC's and NPC's */
 struct char_player_data {
   char	passwd[MAX_PWD_LENGTH+1]; /* character's password                 */
-  std::string name;   	          /* PC / NPC s name (kill ...  )         */
-  std::string short_descr;        /* for NPC 'actions'                    */
-  std::string long_descr;         /* for 'look'			          */
-  std::string description;        /* Extra descriptions                   */
+  shared_string name;   	          /* PC / NPC s name (kill ...  )         */
+  shared_string short_descr;      /* for NPC 'actions'                    */
+  shared_string long_descr;       /* for 'look'			          */
+  shared_string description;      /* Extra descriptions                   */
   std::string title;              /* PC / NPC's title                     */
   byte sex;                       /* PC / NPC's sex                       */
   byte chclass;                   /* PC / NPC's class		          */
@@ -1010,6 +1035,23 @@ struct affected_type {
 };
 
 
+/* Timed affects on characters, by the affect hour they wear off in. */
+struct char_affect;
+typedef std::multimap<unsigned long, std::pair<struct char_data *, struct char_affect *> > affect_schedule;
+
+/*
+ * An affect as a character carries it.  While it counts down, how long is
+ * left is worked out from 'expires' by affect_duration(), and 'duration'
+ * is only what it was given.  While it is held, 'duration' is what's left.
+ */
+struct char_affect : public affected_type {
+  unsigned long expires;	/* affect hour it wears off in, 0 if held or never */
+  affect_schedule::iterator slot;	/* its place in the schedule	*/
+
+  char_affect(const affected_type &af) : affected_type(af), expires(0) {}
+};
+
+
 /* Structure used for chars following other chars */
 struct follow_type {
   struct char_data *follower;
@@ -1035,7 +1077,7 @@ struct char_data {
   struct player_special_data *player_specials; /* PC specials		  */
   struct mob_special_data mob_specials;	/* NPC specials		  */
   
-  std::list<affected_type> affected;
+  std::list<char_affect, pool_allocator<char_affect> > affected;
   struct obj_data *equipment[NUM_WEARS];/* Equipment array               */
 
   struct obj_data *carrying;            /* Head of list                  */
@@ -1043,9 +1085,20 @@ struct char_data {
 
   std::list<follow_type *> followers;   /* List of chars followers       */
   struct char_data *master;             /* Who is char following?        */
+
+  char_list::iterator room_pos; /* Our node in world[in_room].people */
+  char_list::iterator list_pos; /* Our node in character_list */
+  char_list::iterator proto_pos; /* Our node in mob_index[nr].mobiles */
+  zone_rnum counted_in;         /* Zone whose player count includes us */
+  unsigned long serial;         /* From read_mobile(); slots are reused, this isn't */
+  struct timer_event *tick;     /* Our hourly point_update() */
   
   char_data() : pfilepos(0), nr(0), in_room(NOWHERE), was_in_room(NOWHERE), wait(0), player_specials(nullptr), 
-    equipment{nullptr}, carrying(nullptr), desc(nullptr),  master(nullptr) {}
+    equipment{nullptr}, carrying(nullptr), desc(nullptr),  master(nullptr), counted_in(NOWHERE), serial(0), tick(nullptr) {}
+
+  /* Instances come out of a slab_pool; see db.c. */
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
 };
 /* ====================================================================== */
 
@@ -1096,6 +1149,8 @@ struct txt_q {
 };
 
 
+struct compressor;	/* see compressor.h */
+
 struct descriptor_data {
    socket_t	descriptor;	/* file descriptor for socket		*/
    char	host[HOST_LENGTH+1];	/* hostname				*/
@@ -1114,19 +1169,21 @@ struct descriptor_data {
    int	has_prompt;		/* is the user at a prompt?             */
    char	inbuf[MAX_RAW_INPUT_LENGTH];  /* buffer for raw input		*/
    char	last_input[MAX_INPUT_LENGTH]; /* the last input			*/
-   char small_outbuf[SMALL_BUFSIZE];  /* standard output buffer		*/
-   char *output;		/* ptr to the current output buffer	*/
+   out_chain output;		/* output waiting to be sent		*/
+   bool	overflow;		/* output was dropped: say so		*/
+   out_chain wire;		/* bytes to send just as they are	*/
+   std::shared_ptr<struct compressor> mccp; /* MCCP stream, once agreed */
    char **history;		/* History of commands, for ! mostly.	*/
    int	history_pos;		/* Circular array position.		*/
-   int  bufptr;			/* ptr to end of current output		*/
-   int	bufspace;		/* space left in the output buffer	*/
-   struct txt_block *large_outbuf; /* ptr to large buffer, if we need it */
    struct txt_q input;		/* q of unprocessed input		*/
    struct char_data *character;	/* linked to char			*/
    struct char_data *original;	/* original char if switched		*/
    struct descriptor_data *snooping; /* Who is this char snooping	*/
    struct descriptor_data *snoop_by; /* And who is snooping this char	*/
    struct descriptor_data *next; /* link to next descriptor		*/
+   unsigned long host_lookup;	/* resolver ticket, 0 when none pending */
+   unsigned long crypt_job;	/* password hash ticket while verifying */
+   int	crypt_state;		/* state the pending hash answers for	*/
 };
 
 
@@ -1210,6 +1267,10 @@ struct index_data {
    mob_vnum	vnum;	/* virtual number of this mob/obj		*/
    int		number;	/* number of existing units of this mob/obj	*/
    SPECIAL(*func);
+
+   /* The live instances of this prototype, oldest first. */
+   char_list mobiles;
+   obj_list objects;
 };
 
 struct guild_info_type {
@@ -248,7 +248,7 @@ extern void abort (), exit ();
 
 /* Header files only used in comm.c and some of the utils */
 
-#if defined(__COMM_C__) || defined(CIRCLE_UTIL)
+#if defined(__COMM_C__) || defined(__POLLER_C__) || defined(__RESOLVER_C__) || defined(CIRCLE_UTIL)
 
 #ifndef HAVE_STRUCT_IN_ADDR
 struct in_addr {
@@ -260,6 +260,10 @@ struct in_addr {
 #include <sys/select.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
@@ -309,14 +313,14 @@ struct in_addr {
 #endif /* __COMM_C__ && CIRCLE_UNIX */
 
 
-/* Header files that are only used in act.other.c */
-#ifdef __ACT_OTHER_C__
+/* Header files that are only used in act.other.c and snapshot.c */
+#if defined(__ACT_OTHER_C__) || defined(__SNAPSHOT_C__)
 
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
 
-#endif /* __ACT_OTHER_C__ */
+#endif /* __ACT_OTHER_C__ || __SNAPSHOT_C__ */
 
 
 /* Basic system dependencies *******************************************/
@@ -0,0 +1,104 @@
+/*
+ * task_pool.h
+ *
+ * A fixed set of threads for spreading boot-time work over every core.
+ * run() queues a task and hands back a std::future for its result.  A
+ * task must never wait on another task from the same pool.
+ */
+
+#ifndef __TASK_POOL_H__
+#define __TASK_POOL_H__
+
+#include <deque>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+class task_pool {
+  std::vector<std::thread> _workers;
+
+  std::mutex _lock;
+  std::condition_variable _wakeup;
+  std::deque<std::function<void()> > _tasks;
+  bool _stopping = false;
+
+  void work(void) noexcept
+  {
+    std::unique_lock<std::mutex> guard(_lock);
+
+    for (;;) {
+      _wakeup.wait(guard, [this] { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty())
+        return;
+
+      auto task = std::move(_tasks.front());
+      _tasks.pop_front();
+
+      guard.unlock();
+      task();
+      guard.lock();
+    }
+  }
+
+public:
+  explicit task_pool(unsigned threads)
+  {
+    for (unsigned i = 0; i < (threads > 0 ? threads : 1); i++)
+      _workers.push_back(std::thread(&task_pool::work, this));
+  }
+
+  /* Queued tasks still run before the workers exit. */
+  ~task_pool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stopping = true;
+    }
+    _wakeup.notify_all();
+
+    for (auto it = _workers.begin(); it != _workers.end(); ++it)
+      it->join();
+  }
+
+  task_pool(const task_pool &p) = delete;
+  task_pool(task_pool &&p) = delete;
+  const task_pool &operator=(const task_pool &p) = delete;
+  const task_pool &operator=(task_pool &&p) = delete;
+
+  unsigned size(void) const { return _workers.size(); }
+
+  template<class F>
+  std::future<typename std::result_of<F()>::type> run(F f)
+  {
+    typedef typename std::result_of<F()>::type result_type;
+    auto task = std::make_shared<std::packaged_task<result_type()> >(std::move(f));
+    auto result = task->get_future();
+
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _tasks.push_back([task] { (*task)(); });
+    }
+    _wakeup.notify_one();
+
+    return result;
+  }
+};
+
+/*
+ * The pool the world loaders share, one thread per core.  It is never
+ * destroyed: a parser that exit()s on bad input would otherwise have its
+ * own thread joined from under it.
+ */
+inline task_pool &boot_pool(void)
+{
+  static task_pool *pool = new task_pool(std::thread::hardware_concurrency());
+
+  return *pool;
+}
+
+#endif /* __TASK_POOL_H__ */
@@ -0,0 +1,35 @@
+/*
+ * timer_wheel.h
+ *
+ * Timed events for the game loop.  They wait on a hierarchical timing
+ * wheel, so adding, cancelling and running one costs the same however
+ * many others are waiting, and a pulse with nothing due costs next to
+ * nothing.  Time is counted in pulses: each run_timers() is one.
+ */
+
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <functional>
+#include <cstddef>
+
+/*
+ * What an event does when it comes due.  It returns the number of pulses
+ * until it should run again, or 0 if it is finished.  An event that
+ * finishes itself that way must not still be held by anyone, since it
+ * is gone as soon as it returns.
+ */
+typedef std::function<long(void)> timer_func;
+
+struct timer_event;
+
+/* Run func 'delay' pulses from now (1 is the next pulse). */
+struct timer_event *add_timer(long delay, timer_func func);
+
+/* Safe from inside the event itself; does nothing to a null event. */
+void cancel_timer(struct timer_event *&event);
+
+void run_timers(void);
+size_t timers_pending(void);
+
+#endif /* __TIMER_WHEEL_H__ */
@@ -114,7 +114,8 @@ void	gain_exp(struct char_data *ch, int gain);
 void	gain_exp_regardless(struct char_data *ch, int gain);
 void	gain_condition(struct char_data *ch, int condition, int value);
 void	check_idling(struct char_data *ch);
-void	point_update(void);
+void	start_point_update(struct char_data *ch);
+void	start_corpse_decay(struct obj_data *corpse);
 void	update_pos(struct char_data *victim);
 
 
@@ -145,6 +146,7 @@ void	update_pos(struct char_data *victim);
 #define SECS_PER_MUD_DAY	(24*SECS_PER_MUD_HOUR)
 #define SECS_PER_MUD_MONTH	(35*SECS_PER_MUD_DAY)
 #define SECS_PER_MUD_YEAR	(17*SECS_PER_MUD_MONTH)
+#define PULSE_MUD_HOUR		(SECS_PER_MUD_HOUR RL_SEC)
 
 /* real-life time (remember Real Life?) */
 #define SECS_PER_REAL_MIN	60
@@ -0,0 +1,82 @@
+/*
+ * vnum_index.h
+ *
+ * Direct-indexed vnum -> rnum lookup used by real_room(), real_mobile(),
+ * real_object() and real_zone().
+ */
+
+#ifndef __VNUM_INDEX_H__
+#define __VNUM_INDEX_H__
+
+#include <vector>
+
+#include "structs.h"
+
+/*
+ * Vnums are IDXTYPE, so a dense table spanning [lowest, highest] vnum is
+ * never more than 64k slots and sparse worlds need no hash fallback.  When
+ * a vnum appears twice the first rnum wins, as with the old linear search.
+ */
+class vnum_index {
+  int _base = 0;
+  std::vector<IDXTYPE> _slots;
+
+  static bool valid(int vnum) { return vnum >= 0 && vnum != (int) NOWHERE; }
+
+  /* Widen the table so that vnum has a slot. */
+  void cover(int vnum)
+  {
+    if (_slots.empty()) {
+      _base = vnum;
+      _slots.assign(1, NOWHERE);
+    } else if (vnum < _base) {
+      _slots.insert(_slots.begin(), _base - vnum, NOWHERE);
+      _base = vnum;
+    } else if (vnum - _base >= (int) _slots.size())
+      _slots.resize(vnum - _base + 1, NOWHERE);
+  }
+
+public:
+  template<class C, class F>
+  void build(const C &table, F vnum_of)
+  {
+    int lo = -1, hi = -1;
+
+    _slots.clear();
+    for (const auto &entry : table) {
+      int vnum = vnum_of(entry);
+      if (!valid(vnum))
+        continue;
+      if (lo < 0 || vnum < lo)
+        lo = vnum;
+      if (vnum > hi)
+        hi = vnum;
+    }
+    if (lo < 0)
+      return;
+
+    _base = lo;
+    _slots.assign(hi - lo + 1, NOWHERE);
+    for (size_t rnum = 0; rnum < table.size(); rnum++)
+      add(vnum_of(table[rnum]), rnum);
+  }
+
+  /* For entries appended after boot (OLC and friends). */
+  void add(int vnum, IDXTYPE rnum)
+  {
+    if (!valid(vnum))
+      return;
+    cover(vnum);
+    if (_slots[vnum - _base] == NOWHERE)
+      _slots[vnum - _base] = rnum;
+  }
+
+  IDXTYPE find(int vnum) const
+  {
+    if (!valid(vnum) || vnum < _base || vnum - _base >= (int) _slots.size())
+      return (NOWHERE);
+    return (_slots[vnum - _base]);
+  }
+};
+
+#endif /* __VNUM_INDEX_H__ */
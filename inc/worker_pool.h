@@ -0,0 +1,126 @@
+/*
+ * worker_pool.h
+ *
+ * A few threads that run slow, self-contained jobs (DNS lookups, password
+ * hashing) off the game thread.  Jobs are identified by the ticket submit()
+ * returns; game_loop() polls collect() once per pass for finished ones, or
+ * waits a little with wait_idle() when the answers are wanted this pass.
+ * Nothing here ever touches game state.
+ */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+
+template<class Job, class Result>
+class worker_pool {
+  std::function<Result(const Job &)> _work;
+  std::vector<std::thread> _workers;
+
+  std::mutex _lock;
+  std::condition_variable _wakeup;
+  std::condition_variable _idle;	/* no jobs queued or running */
+  std::deque<std::pair<unsigned long, Job> > _jobs;
+  std::deque<std::pair<unsigned long, Result> > _results;
+  unsigned long _last_ticket = 0;
+  int _running = 0;
+  bool _stopping = false;
+
+  void run(void) noexcept
+  {
+    std::unique_lock<std::mutex> guard(_lock);
+
+    for (;;) {
+      _wakeup.wait(guard, [this] { return _stopping || !_jobs.empty(); });
+      if (_stopping)
+        return;
+
+      auto job = std::move(_jobs.front());
+      _jobs.pop_front();
+      _running++;
+
+      guard.unlock();
+      Result result = _work(job.second);
+      guard.lock();
+
+      _results.push_back(std::make_pair(job.first, std::move(result)));
+      if (--_running == 0 && _jobs.empty())
+        _idle.notify_all();
+    }
+  }
+
+public:
+  worker_pool(std::function<Result(const Job &)> work, int threads) : _work(work)
+  {
+    for (int i = 0; i < (threads > 0 ? threads : 1); i++)
+      _workers.push_back(std::thread(&worker_pool::run, this));
+  }
+
+  /* Queued jobs are dropped; one already running is waited for. */
+  ~worker_pool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stopping = true;
+      _jobs.clear();
+    }
+    _wakeup.notify_all();
+
+    for (auto it = _workers.begin(); it != _workers.end(); ++it)
+      it->join();
+  }
+
+  worker_pool(const worker_pool &p) = delete;
+  worker_pool(worker_pool &&p) = delete;
+  const worker_pool &operator=(const worker_pool &p) = delete;
+  const worker_pool &operator=(worker_pool &&p) = delete;
+
+  /* Never returns 0, so callers can use 0 for "nothing pending". */
+  unsigned long submit(Job job)
+  {
+    unsigned long ticket;
+
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      if (++_last_ticket == 0)
+        ++_last_ticket;
+      ticket = _last_ticket;
+      _jobs.push_back(std::make_pair(ticket, std::move(job)));
+    }
+    _wakeup.notify_one();
+
+    return (ticket);
+  }
+
+  /* Waits up to 'limit' for every job so far to finish; true if they did. */
+  bool wait_idle(std::chrono::milliseconds limit)
+  {
+    std::unique_lock<std::mutex> guard(_lock);
+
+    return (_idle.wait_for(guard, limit, [this] { return _jobs.empty() && _running == 0; }));
+  }
+
+  /* Non-blocking; hands back one finished job if there is one. */
+  bool collect(unsigned long &ticket, Result &result)
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (_results.empty())
+      return (false);
+
+    ticket = _results.front().first;
+    result = std::move(_results.front().second);
+    _results.pop_front();
+    return (true);
+  }
+};
+
+#endif /* __WORKER_POOL_H__ */
@@ -483,7 +483,9 @@ ACMD(do_gen_comm)
 
   snprintf(buf1, sizeof(buf1), "$n %ss, '%s'", com_msgs[subcmd][1], argument);
 
-  /* now send all the strings out */
+  /* now send all the strings out, each way of reading it made only once */
+  act_broadcast message(buf1, ch, 0, 0, color_on);
+
   for (i = descriptor_list; i; i = i->next) {
     if (STATE(i) == CON_PLAYING && i != ch->desc && i->character &&
 	!PRF_FLAGGED(i->character, channels[subcmd]) &&
@@ -495,11 +497,7 @@ ACMD(do_gen_comm)
 	   !AWAKE(i->character)))
 	continue;
 
-      if (COLOR_LEV(i->character) >= C_NRM)
-	send_to_char(i->character, "%s", color_on);
-      act(buf1, FALSE, ch, 0, i->character, CommTarget::TO_VICT | CommTarget::TO_SLEEP);
-      if (COLOR_LEV(i->character) >= C_NRM)
-	send_to_char(i->character, "%s", KNRM);
+      message.send(i->character);
     }
   }
 }
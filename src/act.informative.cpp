@@ -101,7 +101,7 @@ namespace {
       switch (GET_OBJ_TYPE(obj)) {
       case ITEM_NOTE:
         if (!obj->action_description.empty()) {
-          std::string note = "There is something written on it:\r\n\r\n" + obj->action_description;
+          std::string note = "There is something written on it:\r\n\r\n" + obj->action_description.str();
           page_string(ch->desc, note);
         } else {
           send_to_char(ch, "It's blank.\r\n");
@@ -143,7 +143,7 @@ namespace {
     }
   }
 
-  void list_obj_to_char(const std::list<obj_data *> &list, struct char_data *ch, int mode, int show)
+  void list_obj_to_char(const obj_list &list, struct char_data *ch, int mode, int show)
   {
     bool found = false;
 
@@ -358,7 +358,7 @@ namespace {
     }
 
     if (IS_NPC(i))
-      send_to_char(ch, "%c%s", UPPER(*i->player.short_descr.c_str()), i->player.short_descr.substr(1).c_str());
+      send_to_char(ch, "%c%s", UPPER(*i->player.short_descr.c_str()), i->player.short_descr.str().substr(1).c_str());
     else
       send_to_char(ch, "%s %s", i->player.name.c_str(), GET_TITLE(i));
 
@@ -400,7 +400,7 @@ namespace {
       act("...$e glows with a bright light!", FALSE, i, 0, ch, CommTarget::TO_VICT);
   }
 
-  void list_char_to_char(const std::list<char_data *> &list, struct char_data *ch)
+  void list_char_to_char(const char_list &list, struct char_data *ch)
   {
     struct char_data *i;
 
@@ -104,8 +104,7 @@ namespace {
         send_to_char(ch, "You don't see %s %s here.\r\n", AN(arg), arg);
       }
       else {      
-        while(!world[IN_ROOM(ch)].contents.empty() && howmany--) {
-          obj = world[IN_ROOM(ch)].contents.front();
+        while (obj && howmany--) {
           perform_get_from_room(ch, obj);
           obj = get_obj_in_list_vis(ch, arg, nullptr, world[IN_ROOM(ch)].contents);
         }
@@ -116,8 +115,9 @@ namespace {
         return;
       }
 
-      while(!world[IN_ROOM(ch)].contents.empty()) {
-        obj = world[IN_ROOM(ch)].contents.front();
+      /* Step on first: what we take leaves the list, what we can't stays. */
+      for (auto it = world[IN_ROOM(ch)].contents.begin(); it != world[IN_ROOM(ch)].contents.end(); ) {
+        obj = *it++;
 
         if (CAN_SEE_OBJ(ch, obj) && (dotmode == FIND_ALL || isname(arg, obj->name.c_str()))) {
           found = 1;
@@ -25,6 +25,7 @@
 #include "act.h"
 #include "interpreter.h"
 #include "fight.h"
+#include "graph.h"
 
 
 namespace {
@@ -174,6 +175,8 @@ namespace {
       OPEN_DOOR(IN_ROOM(ch), obj, door);
       if (back)
         OPEN_DOOR(other_room, obj, rev_dir[door]);
+      if (!obj)
+        door_changed();
       send_to_char(ch, "%s", OK.c_str());
       break;
 
@@ -181,6 +184,8 @@ namespace {
       CLOSE_DOOR(IN_ROOM(ch), obj, door);
       if (back)
         CLOSE_DOOR(other_room, obj, rev_dir[door]);
+      if (!obj)
+        door_changed();
       send_to_char(ch, "%s", OK.c_str());
       break;
 
@@ -31,6 +31,7 @@
 #include "alias.h"
 #include "objsave.h"
 #include "shop.h"
+#include "graph.h"
 
 
 namespace {
@@ -955,6 +956,7 @@ ACMD(do_gen_tog)
     break;
   case SCMD_TRACK:
     result = (track_through_doors = !track_through_doors);
+    routes_changed();
     break;
   default:
     basic_mud_log("SYSERR: Unknown subcmd %d in do_gen_toggle.", subcmd);
@@ -48,7 +48,7 @@ std::vector<social_messg> soc_mess_list;
 namespace {
   int find_action(int cmd)
   {
-    auto found = std::find_if(soc_mess_list.begin(), soc_mess_list.end(), [=](social_messg msg) { return msg.act_nr == cmd; });
+    auto found = std::find_if(soc_mess_list.begin(), soc_mess_list.end(), [=](const social_messg &msg) { return msg.act_nr == cmd; });
     if (found == soc_mess_list.end()) {
       return -1;
     }
@@ -228,4 +228,10 @@ void boot_social_messages(void)
 
   /* now, sort 'em */
   std::sort(soc_mess_list.begin(), soc_mess_list.end(), [](social_messg a, social_messg b) { return a.act_nr < b.act_nr; });
+
+  /* Only now are they where they will stay; compile them for act(). */
+  for (const social_messg &soc : soc_mess_list)
+    for (const std::string *msg : { &soc.others_no_arg, &soc.char_found, &soc.others_found,
+				    &soc.vict_found, &soc.others_auto })
+      precompile_act(msg->c_str());
 }
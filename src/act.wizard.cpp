@@ -32,6 +32,7 @@
 #include "class.h"
 #include "limits_c.h"
 #include "house.h"
+#include "compressor.h"
 
 namespace {
   #define PC   1
@@ -327,6 +328,7 @@ namespace {
       }
       RANGE(0, LVL_IMPL);
       vict->player.level = value;
+      update_zone_players(vict);
       break;
     case 35:
       if ((rnum = real_room(value)) == NOWHERE) {
@@ -641,9 +643,9 @@ namespace {
     CCGRN(ch, C_NRM), vnum, CCNRM(ch, C_NRM), GET_OBJ_RNUM(j), buf,
     GET_OBJ_SPEC(j) ? "Exists" : "None");
 
-    if (!j->ex_description.empty()) {
+    if (!j->ex_description->empty()) {
       send_to_char(ch, "Extra descs:%s", CCCYN(ch, C_NRM));
-      std::for_each(j->ex_description.begin(), j->ex_description.end(),[&ch](const extra_descr_data &e){ send_to_char(ch, " %s", e.keyword.c_str()); });
+      std::for_each(j->ex_description->begin(), j->ex_description->end(),[&ch](const extra_descr_data &e){ send_to_char(ch, " %s", e.keyword.c_str()); });
 
       send_to_char(ch, "%s\r\n", CCNRM(ch, C_NRM));
     }
@@ -896,7 +898,7 @@ namespace {
     /* Routine to show what spells a char is affected by */
     if (!k->affected.empty()) {
       for (auto it = k->affected.begin(); it != k->affected.end() ; ++it) {
-        send_to_char(ch, "SPL: (%3dhr) %s%-21s%s ", it->duration + 1, CCCYN(ch, C_NRM), skill_name(it->type), CCNRM(ch, C_NRM));
+        send_to_char(ch, "SPL: (%3dhr) %s%-21s%s ", affect_duration(*it) + 1, CCCYN(ch, C_NRM), skill_name(it->type), CCNRM(ch, C_NRM));
 
         if (it->modifier)
     send_to_char(ch, "%+d to %s", it->modifier, apply_types[(int) it->location]);
@@ -931,11 +933,11 @@ namespace {
   size_t print_zone_to_buf(char *bufptr, size_t left, zone_rnum zone)
   {
     return snprintf(bufptr, left,
-    "%3d %-30.30s Age: %3d; Reset: %3d (%1d); Range: %5d-%5d\r\n",
+    "%3d %-30.30s Age: %3d; Reset: %3d (%1d); Range: %5d-%5d; Players: %d\r\n",
         zone_table[zone].number, zone_table[zone].name.c_str(),
         zone_table[zone].age, zone_table[zone].lifespan,
         zone_table[zone].reset_mode,
-        zone_table[zone].bot, zone_table[zone].top);
+        zone_table[zone].bot, zone_table[zone].top, zone_table[zone].players);
   }
 } // anonymous namespace
 
@@ -1373,6 +1375,7 @@ ACMD(do_switch)
 
     victim->desc = ch->desc;
     ch->desc = NULL;
+    update_zone_players(victim);
   }
 }
 
@@ -1403,7 +1406,9 @@ ACMD(do_return)
 
     /* And our body's pointer to descriptor now points to our descriptor. */
     ch->desc->character->desc = ch->desc;
+    update_zone_players(ch->desc->character);
     ch->desc = NULL;
+    update_zone_players(ch);
   }
 }
 
@@ -1534,6 +1539,7 @@ ACMD(do_purge)
           STATE(vict->desc) = CON_CLOSE;
           vict->desc->character = nullptr;
           vict->desc = nullptr;
+          update_zone_players(vict);
         }
       }
       extract_char(vict);
@@ -1659,6 +1665,7 @@ ACMD(do_advance)
   if (newlevel < GET_LEVEL(victim)) {
     do_start(victim);
     GET_LEVEL(victim) = newlevel;
+    update_zone_players(victim);
     send_to_char(victim, "You are momentarily enveloped by darkness!\r\nYou feel somewhat diminished.\r\n");
   } else {
     act("$n makes some strange gestures.\r\n"
@@ -2238,8 +2245,8 @@ ACMD(do_wizutil)
       break;
     case SCMD_UNAFFECT:
       if (!vict->affected.empty()) {
-	std::for_each(vict->affected.begin(), vict->affected.end(),[&vict](affected_type &a) { affect_remove(vict, a); });
-	vict->affected.clear();
+	while (!vict->affected.empty())
+	  affect_remove(vict, vict->affected.front());
 
 	send_to_char(vict, "There is a brief flash of light!\r\nYou feel slightly different.\r\n");
 	send_to_char(ch, "All spells removed.\r\n");
@@ -2397,16 +2404,31 @@ ACMD(do_show)
 	"  %5d mobiles          %5ld prototypes\r\n"
 	"  %5d objects          %5ld prototypes\r\n"
 	"  %5ld rooms            %5ld zones\r\n"
-	"  %5d large bufs\r\n"
-	"  %5d buf switches     %5d overflows\r\n",
+	"  %5d output overflows\r\n",
 	i, con,
 	player_table.size(),
 	j, mob_proto.size(),
 	k, obj_proto.size(),
 	world.size(), zone_table.size(),
-	buf_largecount,
-	buf_switches, buf_overflows
+	buf_overflows
 	);
+
+    send_to_char(ch, "Game loop: %lu passes, %lu overran %d ms, longest %ld ms\r\n",
+	loop_passes, loop_overruns, OPT_USEC / 1000, loop_longest / 1000);
+
+    con = 0;
+    for (struct descriptor_data *d = descriptor_list; d; d = d->next)
+      if (d->mccp)
+	con++;
+    send_to_char(ch, "Compression: %d connections, %llu bytes to %llu (%llu saved), %.0f ms cpu\r\n",
+	con, compress_bytes_in, compress_bytes_out,
+	compress_bytes_in - std::min(compress_bytes_in, compress_bytes_out), compress_cpu_msec);
+
+    send_to_char(ch, "Memory pools:\r\n");
+    for (const slab_pool *pool : slab_pool::all())
+      send_to_char(ch, "  %-11s %4lu bytes: %6lu in use, %6lu peak, %3lu slabs, %8lu allocations\r\n",
+	pool->name(), (unsigned long) pool->slot_size(), pool->in_use(), pool->peak(),
+	(unsigned long) pool->slabs(), pool->allocs());
     break;
 
   /* show errors */
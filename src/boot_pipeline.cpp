@@ -0,0 +1,106 @@
+/*
+ * boot_pipeline.cpp
+ *
+ * Every stage gets a thread of its own rather than a slot on boot_pool():
+ * the world loaders block on tasks in that pool, and a stage waiting on
+ * the pool from inside the pool could starve it on a one-core machine.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+
+#include "structs.h"
+#include "utils.h"
+#include "boot_pipeline.h"
+
+typedef std::chrono::steady_clock boot_clock;
+
+
+static double msecs_since(boot_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(boot_clock::now() - start).count();
+}
+
+
+size_t boot_pipeline::add(const std::string &name, std::initializer_list<size_t> after, std::function<void()> work)
+{
+  stage s;
+
+  s.name = name;
+  s.work = work;
+  s.msecs = 0;
+  for (size_t dep : after) {
+    if (dep >= _stages.size()) {
+      basic_mud_log("SYSERR: Boot stage '%s' waits on a stage added after it.", name.c_str());
+      exit(1);
+    }
+    s.after.push_back(dep);
+  }
+  _stages.push_back(s);
+
+  return (_stages.size() - 1);
+}
+
+
+void boot_pipeline::run(void)
+{
+  boot_clock::time_point start = boot_clock::now();
+  std::vector<std::vector<size_t> > dependents(_stages.size());
+  std::vector<size_t> waiting(_stages.size()), finished;
+  std::vector<std::thread> threads(_stages.size());
+  std::mutex lock;
+  std::condition_variable wakeup;
+  size_t done = 0;
+
+  for (size_t i = 0; i < _stages.size(); i++) {
+    waiting[i] = _stages[i].after.size();
+    for (size_t dep : _stages[i].after)
+      dependents[dep].push_back(i);
+  }
+
+  auto launch = [&](size_t i) {
+    threads[i] = std::thread([&, i] {
+      boot_clock::time_point began = boot_clock::now();
+
+      _stages[i].work();
+      _stages[i].msecs = msecs_since(began);
+
+      std::lock_guard<std::mutex> guard(lock);
+      finished.push_back(i);
+      wakeup.notify_one();
+    });
+  };
+
+  for (size_t i = 0; i < _stages.size(); i++)
+    if (waiting[i] == 0)
+      launch(i);
+
+  std::unique_lock<std::mutex> guard(lock);
+  while (done < _stages.size()) {
+    wakeup.wait(guard, [&] { return !finished.empty(); });
+
+    std::vector<size_t> batch;
+    batch.swap(finished);
+
+    /* Start whatever these were holding up; no need to hold the lock. */
+    guard.unlock();
+    for (size_t i : batch) {
+      threads[i].join();
+      done++;
+      for (size_t next : dependents[i])
+	if (--waiting[next] == 0)
+	  launch(next);
+    }
+    guard.lock();
+  }
+
+  basic_mud_log("%s stage timings:", _name.c_str());
+  for (const auto &s : _stages)
+    basic_mud_log("   %-24s %8.1f ms", s.name.c_str(), s.msecs);
+  basic_mud_log("   %-24s %8.1f ms", "(wall clock)", msecs_since(start));
+}
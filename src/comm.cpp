@@ -13,6 +13,9 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#include <mutex>
+#include <unordered_map>
+
 #include "act.h"
 
 #if CIRCLE_GNU_LIBC_MEMORY_TRACK
@@ -62,6 +65,17 @@
 #include "db.h"
 #include "house.h"
 #include "ban.h"
+#include "poller.h"
+#include "resolver.h"
+#include "hasher.h"
+#include "timer_wheel.h"
+#include "compressor.h"
+#include "simulate.h"
+#include "screen.h"
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #ifdef HAVE_ARPA_TELNET_H
 #include <arpa/telnet.h>
@@ -69,6 +83,10 @@
 #include "telnet.h"
 #endif
 
+#ifndef TELOPT_COMPRESS2
+#define TELOPT_COMPRESS2	86	/* MUD Client Compression Protocol v2 */
+#endif
+
 #ifndef INVALID_SOCKET
 #define INVALID_SOCKET (-1)
 #endif
@@ -84,7 +102,12 @@ extern const char *DFLT_DIR;
 extern const char *DFLT_IP;
 extern const char *LOGNAME;
 extern int max_playing;
-extern int nameserver_is_slow;	/* see config.c */
+extern bool nameserver_is_slow;	/* see config.c */
+extern int resolver_threads;	/* see config.c */
+extern int resolver_timeout;	/* see config.c */
+extern int crypt_threads;	/* see config.c */
+extern int compress_threads;	/* see config.c */
+extern int compress_wait_msec;	/* see config.c */
 extern int auto_save;		/* see config.c */
 extern int autosave_time;	/* see config.c */
 extern int *cmd_sort_info;
@@ -93,10 +116,11 @@ extern struct time_info_data time_info;		/* In db.c */
 
 /* local globals */
 struct descriptor_data *descriptor_list = NULL;		/* master desc list */
-struct txt_block *bufpool = 0;	/* pool of large output buffers */
-int buf_largecount = 0;		/* # of large buffers which exist */
+poller *descriptor_poller = NULL;	/* readiness for mother + descriptors */
 int buf_overflows = 0;		/* # of overflows of output */
-int buf_switches = 0;		/* # of switches from small to large buf */
+unsigned long loop_passes = 0;	/* # of passes through game_loop() */
+unsigned long loop_overruns = 0; /* # of those that took over a pulse */
+long loop_longest = 0;		/* longest pass, in microseconds */
 int circle_shutdown = 0;	/* clean shutdown */
 int circle_reboot = 0;		/* reboot the game after a shutdown */
 int no_specials = 0;		/* Suppress ass. of special routines */
@@ -109,6 +133,9 @@ byte emergency_unban;		/* signal: SIGUSR2 */
 FILE *logfile = NULL;		/* Where to send the log messages. */
 const char *text_overflow = "**OVERFLOW**\r\n";
 
+/* Output segments handed to one writev(); plenty to fill MAX_SOCK_BUF. */
+#define MAX_OUTPUT_IOVECS	16
+
 /* functions in this file */
 RETSIGTYPE reread_wizlists(int sig);
 RETSIGTYPE unrestrict_game(int sig);
@@ -117,6 +144,7 @@ RETSIGTYPE checkpointing(int sig);
 RETSIGTYPE hupsig(int sig);
 ssize_t perform_socket_read(socket_t desc, char *read_point,size_t space_left);
 ssize_t perform_socket_write(socket_t desc, const char *txt,size_t length);
+ssize_t perform_socket_writev(socket_t desc, const struct iovec *iov, int count);
 void echo_off(struct descriptor_data *d);
 void echo_on(struct descriptor_data *d);
 void circle_sleep(struct timeval *timeout);
@@ -137,7 +165,13 @@ int perform_subst(struct descriptor_data *t, char *orig, char *subst);
 void record_usage(void);
 char *make_prompt(struct descriptor_data *point);
 void check_idle_passwords(void);
-void heartbeat(int pulse);
+void check_resolved_hosts(void);
+void check_compressed_output(void);
+static int write_immediately(struct descriptor_data *d, const char *txt);
+static void compress_pending_output(struct descriptor_data *t);
+static size_t process_telnet(struct descriptor_data *t, char *buf, size_t len);
+void heartbeat(void);
+void start_heartbeat(void);
 struct in_addr *get_bind_addr(void);
 int parse_ip(const char *addr, struct in_addr *inaddr);
 int set_sendbuf(socket_t s);
@@ -201,7 +235,7 @@ void gettimeofday(struct timeval *t, struct timezone *dummy)
 int main(int argc, char **argv)
 {
   ush_int port;
-  int pos = 1;
+  int pos = 1, sim_players = -1;
   const char *dir;
 
 #if CIRCLE_GNU_LIBC_MEMORY_TRACK
@@ -243,6 +277,26 @@ int main(int argc, char **argv)
 	exit(1);
       }
       break;
+    case 'b':
+      if (*(argv[pos] + 2))
+	sim_pulses = atol(argv[pos] + 2);
+      else if (++pos < argc)
+	sim_pulses = atol(argv[pos]);
+      if (sim_pulses <= 0) {
+	puts("SYSERR: Number of pulses expected after option -b.");
+	exit(1);
+      }
+      break;
+    case 'p':
+      if (*(argv[pos] + 2))
+	sim_players = atoi(argv[pos] + 2);
+      else if (++pos < argc)
+	sim_players = atoi(argv[pos]);
+      if (sim_players < 0) {
+	puts("SYSERR: Number of players (0 or more) expected after option -p.");
+	exit(1);
+      }
+      break;
     case 'm':
       mini_mud = 1;
       no_rent_check = 1;
@@ -266,12 +320,14 @@ int main(int argc, char **argv)
       break;
     case 'h':
       /* From: Anil Mahajan <amahajan@proxicom.com> */
-      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n"
+      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [-b pulses [-p players]] [port #]\n"
+              "  -b <pulses>    Simulate <pulses> pulses without sockets, then report.\n"
               "  -c             Enable syntax check mode.\n"
               "  -d <directory> Specify library directory (defaults to 'lib').\n"
               "  -h             Print this command line argument help.\n"
               "  -m             Start in mini-MUD mode.\n"
 	      "  -o <file>      Write log to <file> instead of stderr.\n"
+              "  -p <players>   Scripted players to let in with -b.\n"
               "  -q             Quick boot (doesn't scan rent for object limits)\n"
               "  -r             Restrict MUD -- no new players allowed.\n"
               "  -s             Suppress special procedure assignments.\n",
@@ -285,9 +341,14 @@ int main(int argc, char **argv)
     pos++;
   }
 
+  if (sim_players >= 0 && !sim_pulses) {
+    puts("SYSERR: Option -p only goes with -b.");
+    exit(1);
+  }
+
   if (pos < argc) {
     if (!isdigit(*argv[pos])) {
-      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n", argv[0]);
+      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [-b pulses [-p players]] [port #]\n", argv[0]);
       exit(1);
     } else if ((port = atoi(argv[pos])) <= 1024) {
       printf("SYSERR: Illegal port number %d.\n", port);
@@ -312,6 +373,8 @@ int main(int argc, char **argv)
 
   if (scheck)
     boot_world();
+  else if (sim_pulses)
+    simulate_game(sim_pulses, MAX(sim_players, 0));
   else {
     basic_mud_log("Running game on port %d.", port);
     init_game(port);
@@ -362,6 +425,24 @@ void init_game(ush_int port)
   /* If we made it this far, we will be able to restart without problem. */
   remove(KILLSCRIPT_FILE);
 
+  descriptor_poller = create_poller();
+  basic_mud_log("Polling descriptors using %s().", descriptor_poller->name());
+  if (!descriptor_poller->add_listener(mother_desc)) {
+    basic_mud_log("SYSERR: Cannot poll the mother connection.");
+    exit(1);
+  }
+
+  basic_mud_log("Starting %d hostname resolver thread(s).", resolver_threads);
+  init_resolver(resolver_threads);
+
+  basic_mud_log("Starting %d password hasher thread(s).", crypt_threads);
+  init_hashers(crypt_threads);
+
+  if (compress_threads > 0) {
+    basic_mud_log("Starting %d output compressor thread(s).", compress_threads);
+    init_compressors(compress_threads);
+  }
+
   basic_mud_log("Entering game loop.");
 
   game_loop(mother_desc);
@@ -372,6 +453,14 @@ void init_game(ush_int port)
   while (descriptor_list)
     close_socket(descriptor_list);
 
+  descriptor_poller->remove(mother_desc);
+  delete descriptor_poller;
+  descriptor_poller = NULL;
+
+  shutdown_resolver();
+  shutdown_hashers();
+  shutdown_compressors();
+
   CLOSE_SOCKET(mother_desc);
   fclose(player_fl);
 
@@ -580,55 +669,37 @@ int get_max_players(void)
  */
 void game_loop(socket_t mother_desc)
 {
-  fd_set input_set, output_set, exc_set, null_set;
   struct timeval last_time, opt_time, process_time, temp_time;
   struct timeval before_sleep, now, timeout;
   char comm[MAX_INPUT_LENGTH];
   struct descriptor_data *d, *next_d;
-  int pulse = 0, missed_pulses, maxdesc, aliased;
+  int missed_pulses, aliased, result, compressing;
 
   /* initialize various time values */
   null_time.tv_sec = 0;
   null_time.tv_usec = 0;
   opt_time.tv_usec = OPT_USEC;
   opt_time.tv_sec = 0;
-  FD_ZERO(&null_set);
 
   gettimeofday(&last_time, (struct timezone *) 0);
 
+  start_heartbeat();
+
   /* The Main Loop.  The Big Cheese.  The Top Dog.  The Head Honcho.  The.. */
   while (!circle_shutdown) {
 
     /* Sleep if we don't have any connections */
     if (descriptor_list == NULL) {
       basic_mud_log("No connections.  Going to sleep.");
-      FD_ZERO(&input_set);
-      FD_SET(mother_desc, &input_set);
-      if (select(mother_desc + 1, &input_set, (fd_set *) 0, (fd_set *) 0, NULL) < 0) {
+      if (descriptor_poller->wait(NULL) < 0) {
 	if (errno == EINTR)
 	  basic_mud_log("Waking up to process signal.");
 	else
-	  perror("SYSERR: Select coma");
+	  perror("SYSERR: Poll coma");
       } else
 	basic_mud_log("New connection.  Waking up.");
       gettimeofday(&last_time, (struct timezone *) 0);
     }
-    /* Set up the input, output, and exception sets for select(). */
-    FD_ZERO(&input_set);
-    FD_ZERO(&output_set);
-    FD_ZERO(&exc_set);
-    FD_SET(mother_desc, &input_set);
-
-    maxdesc = mother_desc;
-    for (d = descriptor_list; d; d = d->next) {
-#ifndef CIRCLE_WINDOWS
-      if (d->descriptor > maxdesc)
-	maxdesc = d->descriptor;
-#endif
-      FD_SET(d->descriptor, &input_set);
-      FD_SET(d->descriptor, &output_set);
-      FD_SET(d->descriptor, &exc_set);
-    }
 
     /*
      * At this point, we have completed all input, output and heartbeat
@@ -640,6 +711,12 @@ void game_loop(socket_t mother_desc)
     gettimeofday(&before_sleep, (struct timezone *) 0); /* current time */
     timediff(&process_time, &before_sleep, &last_time);
 
+    /* Keep count of how often we fall behind, for 'show stats'. */
+    loop_passes++;
+    if (process_time.tv_sec || process_time.tv_usec >= OPT_USEC)
+      loop_overruns++;
+    loop_longest = std::max<long>(loop_longest, process_time.tv_sec * 1000000L + process_time.tv_usec);
+
     /*
      * If we were asleep for more than one pass, count missed pulses and sleep
      * until we're resynchronized with the next upcoming pulse.
@@ -669,30 +746,36 @@ void game_loop(socket_t mother_desc)
     } while (timeout.tv_usec || timeout.tv_sec);
 
     /* Poll (without blocking) for new input, output, and exceptions */
-    if (select(maxdesc + 1, &input_set, &output_set, &exc_set, &null_time) < 0) {
-      perror("SYSERR: Select poll");
+    if (descriptor_poller->wait(&null_time) < 0) {
+      perror("SYSERR: Poll");
       return;
     }
     /* If there are new connections waiting, accept them. */
-    if (FD_ISSET(mother_desc, &input_set))
+    if (descriptor_poller->readable(mother_desc))
       new_descriptor(mother_desc);
 
+    /* Pick up any hostnames the resolver has found since last pass. */
+    check_resolved_hosts();
+
+    /* Let anyone whose password has been hashed carry on logging in. */
+    check_password_hashes();
+
     /* Kick out the freaky folks in the exception set and marked for close */
     for (d = descriptor_list; d; d = next_d) {
       next_d = d->next;
-      if (FD_ISSET(d->descriptor, &exc_set)) {
-	FD_CLR(d->descriptor, &input_set);
-	FD_CLR(d->descriptor, &output_set);
+      if (descriptor_poller->exception(d->descriptor))
 	close_socket(d);
-      }
     }
 
     /* Process descriptors with input pending */
     for (d = descriptor_list; d; d = next_d) {
       next_d = d->next;
-      if (FD_ISSET(d->descriptor, &input_set))
-	if (process_input(d) < 0)
-	  close_socket(d);
+      if (!descriptor_poller->readable(d->descriptor))
+	continue;
+      if ((result = process_input(d)) < 0)
+	close_socket(d);
+      else if (result == 0)	/* Read everything the kernel had. */
+	descriptor_poller->input_drained(d->descriptor);
     }
 
     /* Process commands we just read from process_input */
@@ -712,6 +795,14 @@ void game_loop(socket_t mother_desc)
           continue;
       }
 
+      /* Anything typed while a password is hashed waits its turn. */
+      if (STATE(d) == CON_VERIFYING)
+        continue;
+
+      /* Nor is a name taken before we know the site's; bans match on it. */
+      if (STATE(d) == CON_GET_NAME && d->host_lookup)
+        continue;
+
       if (!get_from_q(&d->input, comm, &aliased))
         continue;
 
@@ -744,22 +835,47 @@ void game_loop(socket_t mother_desc)
       }
     }
 
+    /*
+     * Hand this pass's output for compressing descriptors, bare prompts
+     * too, to the compressor threads.  Give them a moment, so it can go
+     * out this pass with everyone else's, and put what's done on the wire.
+     */
+    compressing = FALSE;
+    for (d = descriptor_list; d; d = d->next) {
+      if (!d->mccp)
+	continue;
+      if (!d->output.empty())
+	compress_pending_output(d);
+      else if (!d->has_prompt)
+	write_immediately(d, make_prompt(d));
+      else
+	continue;
+      d->has_prompt = TRUE;
+      compressing = TRUE;
+    }
+    if (compressing)
+      wait_for_compressors(compress_wait_msec);
+    check_compressed_output();
+
     /* Send queued output out to the operating system (ultimately to user). */
     for (d = descriptor_list; d; d = next_d) {
       next_d = d->next;
-      if (*(d->output) && FD_ISSET(d->descriptor, &output_set)) {
+      if ((!d->output.empty() || !d->wire.empty()) && descriptor_poller->writable(d->descriptor)) {
 	/* Output for this player is ready. */
 
-        process_output(d);
-        if (d->bufptr == 0)	/* All output sent. */
+        if (process_output(d) < 0)	/* Socket was closed. */
+          continue;
+        /* Only ask for a wakeup if the kernel didn't take all of it. */
+        descriptor_poller->want_output(d->descriptor, !d->wire.empty() || (!d->mccp && !d->output.empty()));
+        if (d->output.empty())	/* All output sent. */
           d->has_prompt = TRUE;
       }
     }
 
     /* Print prompts for other descriptors who had no other output */
     for (d = descriptor_list; d; d = d->next) {
-      if (!d->has_prompt && d->bufptr == 0) {
-	write_to_descriptor(d->descriptor, make_prompt(d));
+      if (!d->has_prompt && d->output.empty()) {
+	write_immediately(d, make_prompt(d));
 	d->has_prompt = TRUE;
       }
     }
@@ -791,7 +907,7 @@ void game_loop(socket_t mother_desc)
 
     /* Now execute the heartbeat functions */
     while (missed_pulses--)
-      heartbeat(++pulse);
+      heartbeat();
 
     /* Check for any signals we may have received. */
     if (reread_wizlist) {
@@ -807,10 +923,6 @@ void game_loop(socket_t mother_desc)
       free_invalid_list();
     }
 
-    /* Roll pulse over after 10 hours */
-    if (pulse >= (10 * 60 * 60 * PASSES_PER_SEC))
-      pulse = 0;
-
 #ifdef CIRCLE_UNIX
     /* Update tics for deadlock protection (UNIX only) */
     tics++;
@@ -819,42 +931,61 @@ void game_loop(socket_t mother_desc)
 }
 
 
-void heartbeat(int pulse)
+/* Things done every mud hour for the whole world at once. */
+static void mud_hour(void)
 {
-  static int mins_since_crashsave = 0;
+  weather_and_time(1);
+  affect_update();
+  fflush(player_fl);
+}
+
 
-  if (!(pulse % PULSE_ZONE))
-    zone_update();
+static void autosave(void)
+{
+  static int mins_since_crashsave = 0;
 
-  if (!(pulse % PULSE_IDLEPWD))		/* 15 seconds */
-    check_idle_passwords();
+  /* A simulation saves nothing; see simulate.c. */
+  if (auto_save && !sim_pulses && ++mins_since_crashsave >= autosave_time) {	/* 1 minute */
+    mins_since_crashsave = 0;
+    Crash_save_all();
+    House_save_all();
+  }
+}
 
-  if (!(pulse % PULSE_MOBILE))
-    mobile_activity();
 
-  if (!(pulse % PULSE_VIOLENCE))
-    perform_violence();
+/* Run func every 'period' pulses, starting 'first' pulses from now. */
+static void every(long period, long first, void (*func)(void))
+{
+  add_timer(first, [period, func] {
+      func();
+      return (period);
+    });
+}
 
-  if (!(pulse % (SECS_PER_MUD_HOUR * PASSES_PER_SEC))) {
-    weather_and_time(1);
-    affect_update();
-    point_update();
-    fflush(player_fl);
-  }
 
-  if (auto_save && !(pulse % PULSE_AUTOSAVE)) {	/* 1 minute */
-    if (++mins_since_crashsave >= autosave_time) {
-      mins_since_crashsave = 0;
-      Crash_save_all();
-      House_save_all();
-    }
-  }
+/*
+ * The periodic work of the game.  Every period is a whole number of
+ * seconds, so starting each one on a different pulse of the first
+ * second means no two of them ever come due on the same pulse.
+ * Characters and corpses keep hours of their own; see limits.c.
+ */
+void start_heartbeat(void)
+{
+  every(PULSE_ZONE,	1, zone_update);
+  every(PULSE_IDLEPWD,	2, check_idle_passwords);	/* 15 seconds */
+  every(PULSE_MOBILE,	3, mobile_activity);
+  every(PULSE_VIOLENCE,	4, perform_violence);
+  every(PULSE_MUD_HOUR,	5, mud_hour);
+  every(PULSE_AUTOSAVE,	6, autosave);
+  every(PULSE_USAGE,	7, record_usage);
+  every(PULSE_TIMESAVE,	8, [] { if (!sim_pulses) save_mud_time(&time_info); });
+}
 
-  if (!(pulse % PULSE_USAGE))
-    record_usage();
 
-  if (!(pulse % PULSE_TIMESAVE))
-    save_mud_time(&time_info);
+void heartbeat(void)
+{
+  run_timers();
+  continue_zone_resets();		/* every pulse, a little at a time */
 
   /* Every pulse! Don't want them to stink the place up... */
   extract_pending_chars();
@@ -1077,10 +1208,10 @@ int get_from_q(struct txt_q *queue, char *dest, int *aliased)
 /* Empty the queues before closing connection */
 void flush_queues(struct descriptor_data *d)
 {
-  if (d->large_outbuf) {
-    d->large_outbuf->next = bufpool;
-    bufpool = d->large_outbuf;
-  }
+  d->output.clear();
+  d->wire.clear();
+  end_compression(d->mccp);
+
   while (d->input.head) {
     struct txt_block *tmp = d->input.head;
     d->input.head = d->input.head->next;
@@ -1104,70 +1235,43 @@ size_t write_to_output(struct descriptor_data *t, const char *txt, ...)
 }
 
 
-/* Add a new string to a player's output queue. */
+/*
+ * Add a new string to a player's output queue.  It is formatted straight
+ * onto the end of the queue, at whatever length; only a player who lets
+ * MAX_OUTPUT_SIZE pile up loses anything.  Returns the length added.
+ */
 size_t vwrite_to_output(struct descriptor_data *t, const char *format, va_list args)
 {
-  static char txt[MAX_STRING_LENGTH];
-  size_t wantsize;
   int size;
 
   /* if we're in the overflow state already, ignore this new output */
-  if (t->bufspace == 0)
+  if (t->overflow)
     return (0);
 
-  wantsize = size = vsnprintf(txt, sizeof(txt), format, args);
-  /* If exceeding the size of the buffer, truncate it for the overflow message */
-  if (size < 0 || wantsize >= sizeof(txt)) {
-    size = sizeof(txt) - 1;
-    strcpy(txt + size - strlen(text_overflow), text_overflow);	/* strcpy: OK */
-  }
-
-  /*
-   * If the text is too big to fit into even a large buffer, truncate
-   * the new text to make it fit.  (This will switch to the overflow
-   * state automatically because t->bufspace will end up 0.)
-   */
-  if (size + t->bufptr + 1 > LARGE_BUFSIZE) {
-    size = LARGE_BUFSIZE - t->bufptr - 1;
-    txt[size] = '\0';
+  if ((size = t->output.vformat(MAX_OUTPUT_SIZE, format, args)) < 0) {
+    t->overflow = true;
     buf_overflows++;
+    return (0);
   }
 
-  /*
-   * If we have enough space, just write to buffer and that's it! If the
-   * text just barely fits, then it's switched to a large buffer instead.
-   */
-  if (t->bufspace > size) {
-    strcpy(t->output + t->bufptr, txt);	/* strcpy: OK (size checked above) */
-    t->bufspace -= size;
-    t->bufptr += size;
-    return (t->bufspace);
-  }
+  return (size);
+}
 
-  buf_switches++;
 
-  /* if the pool has a buffer in it, grab it */
-  if (bufpool != NULL) {
-    t->large_outbuf = bufpool;
-    bufpool = bufpool->next;
-  } else {			/* else create a new one */
+/* Queues text that is already formatted, such as one copy of a broadcast. */
+size_t write_text_to_output(struct descriptor_data *t, const char *txt, size_t len)
+{
+  if (t->overflow)
+    return (0);
 
-    t->large_outbuf = new txt_block,
-    t->large_outbuf->text = new char[LARGE_BUFSIZE];
-    buf_largecount++;
+  if (t->output.length() + len > MAX_OUTPUT_SIZE) {
+    t->overflow = true;
+    buf_overflows++;
+    return (0);
   }
 
-  strcpy(t->large_outbuf->text, t->output);	/* strcpy: OK (size checked previously) */
-  t->output = t->large_outbuf->text;	/* make big buffer primary */
-  strcat(t->output, txt);	/* strcat: OK (size checked) */
-
-  /* set the pointer for the next write */
-  t->bufptr = strlen(t->output);
-
-  /* calculate how much space is left in the buffer */
-  t->bufspace = LARGE_BUFSIZE - 1 - t->bufptr;
-
-  return (t->bufspace);
+  t->output.append(txt, len);
+  return (len);
 }
 
 
@@ -1283,7 +1387,6 @@ int new_descriptor(socket_t s)
   static int last_desc = 0;	/* last descriptor number */
   struct descriptor_data *newd;
   struct sockaddr_in peer;
-  struct hostent *from;
 
   /* accept the new connection */
   i = sizeof(peer);
@@ -1304,32 +1407,25 @@ int new_descriptor(socket_t s)
   for (newd = descriptor_list; newd; newd = newd->next)
     sockets_connected++;
 
-  if (sockets_connected >= max_players) {
+  if (sockets_connected >= max_players || !descriptor_poller->add(desc)) {
     write_to_descriptor(desc, "Sorry, CircleMUD is full right now... please try again later!\r\n");
     CLOSE_SOCKET(desc);
     return (0);
   }
   /* create a new descriptor */
-  newd = new descriptor_data;
-
-  /* find the sitename */
-  if (nameserver_is_slow || !(from = gethostbyaddr((char *) &peer.sin_addr,
-				      sizeof(peer.sin_addr), AF_INET))) {
-
-    /* resolution failed */
-    if (!nameserver_is_slow)
-      perror("SYSERR: gethostbyaddr");
+  newd = new descriptor_data();
 
-    /* find the numeric site address */
-    strncpy(newd->host, (char *)inet_ntoa(peer.sin_addr), HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
-    *(newd->host + HOST_LENGTH) = '\0';
-  } else {
-    strncpy(newd->host, from->h_name, HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
-    *(newd->host + HOST_LENGTH) = '\0';
-  }
+  /*
+   * Start out with the numeric site address; unless the nameserver is
+   * flagged as slow, the resolver threads will look up the name and
+   * check_resolved_hosts() will swap it in later.
+   */
+  strncpy(newd->host, (char *)inet_ntoa(peer.sin_addr), HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
+  *(newd->host + HOST_LENGTH) = '\0';
 
   /* determine if the site is banned */
   if (isbanned(newd->host) == BAN_ALL) {
+    descriptor_poller->remove(desc);
     CLOSE_SOCKET(desc);
     mudlog(CMP, LVL_GOD, TRUE, "Connection attempt denied from [%s]", newd->host);
     delete newd;
@@ -1344,14 +1440,13 @@ int new_descriptor(socket_t s)
   mudlog(CMP, LVL_GOD, FALSE, "New connection from [%s]", newd->host);
 #endif
 
+  if (!nameserver_is_slow)
+    newd->host_lookup = resolve_host(&peer.sin_addr);
+
   /* initialize descriptor data */
   newd->descriptor = desc;
   newd->idle_tics = 0;
-  newd->output = newd->small_outbuf;
-  newd->bufspace = SMALL_BUFSIZE - 1;
   newd->login_time = time(0);
-  *newd->output = '\0';
-  newd->bufptr = 0;
   newd->has_prompt = 1;  /* prompt is part of greetings */
   STATE(newd) = CON_GET_NAME;
 
@@ -1360,7 +1455,7 @@ int new_descriptor(socket_t s)
    * Do we embed the history in descriptor_data or keep it dynamically
    * allocated and allow a user defined history size?
    */
-  newd->history = new char*[HISTORY_SIZE];
+  newd->history = new char*[HISTORY_SIZE]();
 
   if (++last_desc == 1000)
     last_desc = 1;
@@ -1370,6 +1465,13 @@ int new_descriptor(socket_t s)
   newd->next = descriptor_list;
   descriptor_list = newd;
 
+  /* Offer compression; process_telnet() starts it if they say DO. */
+  if (compress_threads > 0) {
+    char will_compress[] = { (char) IAC, (char) WILL, (char) TELOPT_COMPRESS2, (char) 0 };
+
+    write_to_output(newd, "%s", will_compress);
+  }
+
   write_to_output(newd, "%s", GREETINGS.c_str());
 
   return (0);
@@ -1377,98 +1479,184 @@ int new_descriptor(socket_t s)
 
 
 /*
- * Send all of the output that we've accumulated for a player out to
- * the player's descriptor.
- *
- * 32 byte GARBAGE_SPACE in MAX_SOCK_BUF used for:
- *	 2 bytes: prepended \r\n
- *	14 bytes: overflow message
- *	 2 bytes: extra \r\n for non-comapct
- *      14 bytes: unused
+ * What goes out after a player's output: the overflow notice, a blank
+ * line for those not in compact mode, and the prompt.  Fills up to three
+ * iovecs and returns how many it used.
  */
-int process_output(struct descriptor_data *t)
+static int output_trailer(struct descriptor_data *t, struct iovec *iov)
 {
-  char i[MAX_SOCK_BUF], *osb = i + 2;
-  int result;
+  char *prompt = make_prompt(t);
+  int n = 0;
+
+  if (t->overflow) {
+    iov[n].iov_base = (void *) text_overflow;
+    iov[n++].iov_len = strlen(text_overflow);
+  }
+
+  if (STATE(t) == CON_PLAYING && t->character && !IS_NPC(t->character) && !PRF_FLAGGED(t->character, PRF_COMPACT)) {
+    iov[n].iov_base = (void *) "\r\n";
+    iov[n++].iov_len = 2;
+  }
 
-  /* we may need this \r\n for later -- see below */
-  strcpy(i, "\r\n");	/* strcpy: OK (for 'MAX_SOCK_BUF >= 3') */
+  iov[n].iov_base = prompt;
+  iov[n].iov_len = strlen(prompt);
+  return (n + 1);
+}
 
-  /* now, append the 'real' output */
-  strcpy(osb, t->output);	/* strcpy: OK (t->output:LARGE_BUFSIZE < osb:MAX_SOCK_BUF-2) */
 
-  /* if we're in the overflow state, notify the user */
-  if (t->bufspace == 0)
-    strcat(osb, "**OVERFLOW**\r\n");	/* strcpy: OK (osb:MAX_SOCK_BUF-2 reserves space) */
+/* Let whoever is snooping t see the first 'len' bytes of its output. */
+static void snoop_output(struct descriptor_data *t, size_t len)
+{
+  if (!t->snoop_by || !len)
+    return;
 
-  /* add the extra CRLF if the person isn't in compact mode */
-  if (STATE(t) == CON_PLAYING && t->character && !IS_NPC(t->character) && !PRF_FLAGGED(t->character, PRF_COMPACT))
-    strcat(osb, "\r\n");	/* strcpy: OK (osb:MAX_SOCK_BUF-2 reserves space) */
+  t->snoop_by->output.append("% ");
+  t->output.copy_to(t->snoop_by->output, len);
+  t->snoop_by->output.append("%%");
+}
 
-  /* add a prompt */
-  strcat(i, make_prompt(t));	/* strcpy: OK (i:MAX_SOCK_BUF reserves space) */
 
-  /*
-   * now, send the output.  If this is an 'interruption', use the prepended
-   * CRLF, otherwise send the straight output sans CRLF.
-   */
+/*
+ * A compressing descriptor's output, put together the same way
+ * process_output() would send it, goes to the compressor threads whole.
+ */
+static void compress_pending_output(struct descriptor_data *t)
+{
+  struct iovec trailer[3];
+  out_chain text;
+  int i, n;
+
   if (t->has_prompt) {
     t->has_prompt = FALSE;
-    result = write_to_descriptor(t->descriptor, i);
-    if (result >= 2)
-      result -= 2;
-  } else
-    result = write_to_descriptor(t->descriptor, osb);
+    text.append("\r\n");
+  }
+
+  snoop_output(t, t->output.length());
+  text.splice(t->output);
+
+  n = output_trailer(t, trailer);
+  for (i = 0; i < n; i++)
+    text.append((const char *) trailer[i].iov_base, trailer[i].iov_len);
+  t->overflow = false;
+
+  compress_output(t->mccp, text);
+}
+
+
+/*
+ * Text that cannot wait in the output queue, like a bare prompt.  It still
+ * has to follow anything already on the wire, and be compressed with
+ * everything else once MCCP is on.
+ */
+static int write_immediately(struct descriptor_data *d, const char *txt)
+{
+  if (d->mccp) {
+    out_chain text;
+
+    text.append(txt);
+    compress_output(d->mccp, text);
+  } else if (!d->wire.empty())
+    d->wire.append(txt);
+  else
+    return write_to_descriptor(d->descriptor, txt);
+
+  return (0);
+}
+
+
+/* Send as much of a chain as the kernel will take; -1 on a fatal error. */
+static ssize_t write_chain(socket_t desc, out_chain &chain)
+{
+  struct iovec iov[MAX_OUTPUT_IOVECS];
+  ssize_t result;
+
+  result = perform_socket_writev(desc, iov, chain.fill_iovecs(iov, MAX_OUTPUT_IOVECS));
+  if (result > 0)
+    chain.consume(result);
+
+  return (result);
+}
+
+
+/*
+ * Send all of the output that we've accumulated for a player out to
+ * the player's descriptor.  It goes straight out of the output chain with
+ * writev(), behind a CRLF if it interrupts a prompt and ahead of the
+ * trailer from output_trailer().  Whatever the kernel did not take stays
+ * at the front of the chain for next time.
+ *
+ * Bytes on t->wire (the MCCP start marker, compressed output) go first;
+ * a compressing descriptor never sends anything else.
+ */
+int process_output(struct descriptor_data *t)
+{
+  struct iovec iov[MAX_OUTPUT_IOVECS + 4];
+  size_t queued = 0;
+  ssize_t result, written;
+  int i, n = 0, prefix = 0, trailer = 0;
 
-  if (result < 0) {	/* Oops, fatal error. Bye! */
+  if (!t->wire.empty()) {
+    if ((result = write_chain(t->descriptor, t->wire)) < 0) {
+      perror("SYSERR: Write to socket");
+      close_socket(t);
+      return (-1);
+    }
+    if (!t->wire.empty())	/* Socket buffer full. Try later. */
+      return (0);
+  }
+
+  if (t->mccp || t->output.empty())
+    return (0);
+
+  /* The leading CRLF, if this is an 'interruption'. */
+  if (t->has_prompt) {
+    iov[n].iov_base = (void *) "\r\n";
+    iov[n++].iov_len = prefix = 2;
+  }
+
+  /* The output, and if all of it fits the trailer too. */
+  n += t->output.fill_iovecs(iov + n, MAX_OUTPUT_IOVECS);
+  for (i = prefix ? 1 : 0; i < n; i++)
+    queued += iov[i].iov_len;
+  if (queued == t->output.length()) {
+    trailer = output_trailer(t, iov + n);
+    n += trailer;
+  }
+
+  if ((written = result = perform_socket_writev(t->descriptor, iov, n)) < 0) {
+    perror("SYSERR: Write to socket");
     close_socket(t);
     return (-1);
   } else if (result == 0)	/* Socket buffer full. Try later. */
     return (0);
 
+  t->has_prompt = FALSE;
+  result = std::max(static_cast<ssize_t>(0), result - prefix);
+
   /* Handle snooping: prepend "% " and send to snooper. */
-  if (t->snoop_by)
-    write_to_output(t->snoop_by, "%% %*s%%%%", result, t->output);
+  snoop_output(t, std::min(static_cast<size_t>(result), t->output.length()));
 
-  /* The common case: all saved output was handed off to the kernel buffer. */
-  if (result >= t->bufptr) {
-    /*
-     * if we were using a large buffer, put the large buffer on the buffer pool
-     * and switch back to the small one
-     */
-    if (t->large_outbuf) {
-      t->large_outbuf->next = bufpool;
-      bufpool = t->large_outbuf;
-      t->large_outbuf = NULL;
-      t->output = t->small_outbuf;
-    }
-    /* reset total bufspace back to that of a small buffer */
-    t->bufspace = SMALL_BUFSIZE - 1;
-    t->bufptr = 0;
-    *(t->output) = '\0';
+  /* Drop what went out, and keep any part of the trailer that didn't. */
+  if (static_cast<size_t>(result) < t->output.length())
+    t->output.consume(result);
+  else {
+    result -= t->output.length();
+    t->output.clear();
+    t->overflow = false;
 
-    /*
-     * If the overflow message or prompt were partially written, try to save
-     * them. There will be enough space for them if this is true.  'result'
-     * is effectively unsigned here anyway.
-     */
-    if ((unsigned int)result < strlen(osb)) {
-      size_t savetextlen = strlen(osb + result);
+    for (i = n - trailer; i < n; i++) {
+      size_t len = iov[i].iov_len;
 
-      strcat(t->output, osb + result);
-      t->bufptr   -= savetextlen;
-      t->bufspace += savetextlen;
+      if (static_cast<size_t>(result) >= len)
+	result -= len;
+      else {
+	t->output.append((const char *) iov[i].iov_base + result, len - result);
+	result = 0;
+      }
     }
-
-  } else {
-    /* Not all data in buffer sent.  result < output buffersize. */
-
-    strcpy(t->output, t->output + result);	/* strcpy: OK (overlap) */
-    t->bufptr   -= result;
-    t->bufspace += result;
   }
 
-  return (result);
+  return (written);
 }
 
 
@@ -1491,6 +1679,15 @@ int process_output(struct descriptor_data *t)
 
 #if defined(CIRCLE_WINDOWS)
 
+/* No writev() here: send the first piece, and let it be a short write. */
+ssize_t perform_socket_writev(socket_t desc, const struct iovec *iov, int count)
+{
+  if (count == 0)
+    return (0);
+  return perform_socket_write(desc, (const char *) iov[0].iov_base, iov[0].iov_len);
+}
+
+
 ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
 {
   ssize_t result;
@@ -1526,10 +1723,28 @@ ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
 
 /* perform_socket_write for all Non-Windows platforms */
 ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
+{
+  struct iovec iov;
+
+  iov.iov_base = (void *) txt;
+  iov.iov_len = length;
+
+  return perform_socket_writev(desc, &iov, 1);
+}
+
+
+/*
+ * The same for a list of pieces, written in order with one writev(); the
+ * result counts bytes across all of them.
+ */
+ssize_t perform_socket_writev(socket_t desc, const struct iovec *iov, int count)
 {
   ssize_t result;
 
-  result = write(desc, txt, length);
+  if (count == 0)
+    return (0);
+
+  result = writev(desc, iov, count);
 
   if (result > 0) {
     /* Write was successful. */
@@ -1676,6 +1891,57 @@ ssize_t perform_socket_read(socket_t desc, char *read_point, size_t space_left)
   return (-1);
 }
 
+
+/*
+ * Takes the telnet commands out of what was just read, in place, and
+ * returns how much ordinary input is left.  The only option we act on is
+ * a DO COMPRESS2 in answer to our offer; a command split across two reads
+ * is dropped, which clients do not do in practice.
+ */
+static size_t process_telnet(struct descriptor_data *t, char *buf, size_t len)
+{
+  static const char start_mccp[] = { (char) IAC, (char) SB, (char) TELOPT_COMPRESS2, (char) IAC, (char) SE };
+  unsigned char *in = (unsigned char *) buf, *end = in + len;
+  char *out = buf;
+
+  while (in < end) {
+    if (*in != IAC) {
+      *(out++) = *(in++);
+      continue;
+    }
+    if (end - in < 2)
+      break;
+
+    switch (in[1]) {
+    case IAC:			/* a literal 255 */
+      *(out++) = (char) IAC;
+      in += 2;
+      break;
+    case WILL: case WONT: case DO: case DONT:
+      if (end - in < 3) {
+	in = end;
+	break;
+      }
+      if (in[1] == DO && in[2] == TELOPT_COMPRESS2 && !t->mccp && compress_threads > 0) {
+	t->wire.append(start_mccp, sizeof(start_mccp));
+	t->mccp = start_compression(t);
+      }
+      in += 3;
+      break;
+    case SB:			/* skip through IAC SE */
+      for (in += 2; in < end && !(in[0] == IAC && in + 1 < end && in[1] == SE); in++)
+	;
+      in = std::min(in + 2, end);
+      break;
+    default:			/* IAC and one command byte */
+      in += 2;
+      break;
+    }
+  }
+
+  return (out - buf);
+}
+
 /*
  * ASSUMPTION: There will be no newlines in the raw input buffer when this
  * function is called.  We must maintain that before returning.
@@ -1717,6 +1983,7 @@ int process_input(struct descriptor_data *t)
 
     /* at this point, we know we got some data from the read */
 
+    bytes_read = process_telnet(t, read_point, bytes_read);
     *(read_point + bytes_read) = '\0';	/* terminate the string */
 
     /* search for a newline in the data we just read */
@@ -1782,7 +2049,7 @@ int process_input(struct descriptor_data *t)
       char buffer[MAX_INPUT_LENGTH + 64];
 
       snprintf(buffer, sizeof(buffer), "Line too long.  Truncated to:\r\n%s\r\n", tmp);
-      if (write_to_descriptor(t->descriptor, buffer) < 0)
+      if (write_immediately(t, buffer) < 0)
 	return (-1);
     }
     if (t->snoop_by)
@@ -1901,7 +2168,23 @@ void close_socket(struct descriptor_data *d)
 {
   struct descriptor_data *temp;
 
+  /*
+   * A compressing descriptor's last words ("Goodbye.", "Wrong password",
+   * ...) are still with the compressor threads.  Get them back with the
+   * end of the stream, and give them the one try plain text gets.
+   */
+  if (d->mccp) {
+    std::string last;
+
+    if (!d->output.empty())
+      compress_pending_output(d);
+    finish_compression(d->mccp, last);
+    d->wire.append(last.data(), last.size());
+    write_chain(d->descriptor, d->wire);
+  }
+
   REMOVE_FROM_LIST(d, descriptor_list, next);
+  descriptor_poller->remove(d->descriptor);
   CLOSE_SOCKET(d->descriptor);
   flush_queues(d);
 
@@ -1917,6 +2200,7 @@ void close_socket(struct descriptor_data *d)
   if (d->character) {
     /* If we're switched, this resets the mobile taken. */
     d->character->desc = NULL;
+    update_zone_players(d->character);
 
     /* Plug memory leak, from Eric Green. */
     if (!IS_NPC(d->character) && PLR_FLAGGED(d->character, PLR_MAILING) && d->str) {
@@ -1959,10 +2243,70 @@ void close_socket(struct descriptor_data *d)
   if (d->showstr_count)
     free(d->showstr_vector);
 
-  free(d);
+  delete d;
+}
+
+
+
+/*
+ * Give descriptors the hostnames the resolver threads came up with, and
+ * check the ban list again now that there is a name to match against.
+ * Nobody gets past the name prompt while their lookup is pending, so
+ * the select and new-character bans in nanny() only ever see the name.
+ */
+void check_resolved_hosts(void)
+{
+  struct descriptor_data *d;
+  unsigned long ticket;
+  std::string name;
+  time_t now;
+
+  while (collect_resolved_host(&ticket, name)) {
+    for (d = descriptor_list; d; d = d->next)
+      if (d->host_lookup == ticket)
+	break;
+
+    if (!d)		/* They left before we found out who they were. */
+      continue;
+
+    d->host_lookup = 0;
+    if (name.empty())	/* No name; keep the numeric address. */
+      continue;
+
+    strncpy(d->host, name.c_str(), HOST_LENGTH);	/* strncpy: OK (d->host:HOST_LENGTH+1) */
+    *(d->host + HOST_LENGTH) = '\0';
+
+    if (isbanned(d->host) == BAN_ALL) {
+      mudlog(CMP, LVL_GOD, TRUE, "Connection attempt denied from [%s]", d->host);
+      /* Same as do_dc(): don't pull the rug out from under a playing char. */
+      if (STATE(d) == CON_PLAYING)
+	STATE(d) = CON_DISCONNECT;
+      else
+	STATE(d) = CON_CLOSE;
+    }
+  }
+
+  /* Don't hold anyone at the name prompt for a nameserver that won't answer. */
+  now = time(0);
+  for (d = descriptor_list; d; d = d->next)
+    if (d->host_lookup && now - d->login_time >= resolver_timeout) {
+      basic_mud_log("Lookup of [%s] timed out; keeping the address.", d->host);
+      d->host_lookup = 0;	/* The answer, if it comes, finds no one. */
+    }
 }
 
 
+/* Queue up the bytes the compressor threads have finished, for sending. */
+void check_compressed_output(void)
+{
+  struct descriptor_data *d;
+  std::string bytes;
+
+  while (collect_compressed_output(&d, bytes))
+    if (d)	/* NULL if they have gone since. */
+      d->wire.append(bytes.data(), bytes.size());
+}
+
 
 void check_idle_passwords(void)
 {
@@ -2196,21 +2540,45 @@ size_t send_to_char(struct char_data *ch, const char *messg, ...)
 }
 
 
+/* The send_to_x() broadcasts format their message once, here. */
+static void vformat_message(std::string &txt, const char *messg, va_list args)
+{
+  char buf[MAX_STRING_LENGTH];
+  va_list again;
+  int len;
+
+  va_copy(again, args);
+  if ((len = vsnprintf(buf, sizeof(buf), messg, args)) < 0)
+    txt.clear();
+  else if (static_cast<size_t>(len) < sizeof(buf))
+    txt.assign(buf, len);
+  else {
+    txt.assign(len + 1, '\0');
+    vsnprintf(&txt[0], len + 1, messg, again);
+    txt.resize(len);
+  }
+  va_end(again);
+}
+
+
 void send_to_all(const char *messg, ...)
 {
   struct descriptor_data *i;
+  std::string txt;
   va_list args;
 
   if (messg == NULL)
     return;
 
+  va_start(args, messg);
+  vformat_message(txt, messg, args);
+  va_end(args);
+
   for (i = descriptor_list; i; i = i->next) {
     if (STATE(i) != CON_PLAYING)
       continue;
 
-    va_start(args, messg);
-    vwrite_to_output(i, messg, args);
-    va_end(args);
+    write_text_to_output(i, txt.data(), txt.size());
   }
 }
 
@@ -2218,21 +2586,23 @@ void send_to_all(const char *messg, ...)
 void send_to_outdoor(const char *messg, ...)
 {
   struct descriptor_data *i;
+  std::string txt;
+  va_list args;
 
   if (!messg || !*messg)
     return;
 
-  for (i = descriptor_list; i; i = i->next) {
-    va_list args;
+  va_start(args, messg);
+  vformat_message(txt, messg, args);
+  va_end(args);
 
+  for (i = descriptor_list; i; i = i->next) {
     if (STATE(i) != CON_PLAYING || i->character == NULL)
       continue;
     if (!AWAKE(i->character) || !OUTSIDE(i->character))
       continue;
 
-    va_start(args, messg);
-    vwrite_to_output(i, messg, args);
-    va_end(args);
+    write_text_to_output(i, txt.data(), txt.size());
   }
 }
 
@@ -2240,19 +2610,22 @@ void send_to_outdoor(const char *messg, ...)
 
 void send_to_room(room_rnum room, const char *messg, ...)
 {
+  std::string txt;
+  va_list args;
+
   if (messg == nullptr) {
     return;
   }
 
+  va_start(args, messg);
+  vformat_message(txt, messg, args);
+  va_end(args);
+
   for (auto it = world[room].people.begin(); it != world[room].people.end(); it++) {
     auto i = *it;
     
     if (i->desc) {
-      va_list args;
-
-      va_start(args, messg);
-      vwrite_to_output(i->desc, messg, args);
-      va_end(args);      
+      write_text_to_output(i->desc, txt.data(), txt.size());
     }
   }
 }
@@ -2264,112 +2637,284 @@ const char *ACTNULL = "<NULL>";
 #define CHECK_NULL(pointer, expression) \
   if ((pointer) == NULL) i = ACTNULL; else i = (expression);
 
+/*
+ * Compiled act() strings.  Those read at boot (combat messages, socials)
+ * are pinned; anything else is kept by its text until there are
+ * MAX_ACT_TEMPLATES of them, and then those are all dropped.  Since the
+ * same address can hold new text from one call to the next (a static
+ * buffer, say), a hit by address is checked against the text.
+ */
+#define MAX_ACT_TEMPLATES	4096
+
+static std::unordered_map<std::string, act_template> act_templates;
+static std::unordered_map<const char *, act_template *> act_by_address;
+static size_t act_pinned = 0;
 
-/* higher-level communication: the act() function */
-void perform_act(const char *orig, struct char_data *ch, struct obj_data *obj,
-		const void *vict_obj, const struct char_data *to)
+
+static void compile_act(const char *str, act_template &t)
+{
+  const char *c, *run;
+
+  t.source = str;
+  t.text.clear();
+  t.tokens.clear();
+  t.names_ch = t.per_listener = false;
+
+  for (c = str; *c; ) {
+    if (*c != '$' || *(c + 1) == '$') {
+      /* Plain text, and $$ as a '$', run together into one piece. */
+      if (t.tokens.empty() || t.tokens.back().code)
+	t.tokens.push_back({ '\0', t.text.size(), 0 });
+      if (*c == '$')
+	c++;
+      for (run = c++; *c && *c != '$'; c++)
+	;
+      t.text.append(run, c - run);
+      t.tokens.back().len = t.text.size() - t.tokens.back().start;
+      continue;
+    }
+
+    switch (*(++c)) {
+    case 'n':
+      t.names_ch = true;
+      break;
+    case 'N': case 'o': case 'O': case 'p': case 'P':
+      t.per_listener = true;
+      break;
+    case 'm': case 'M': case 's': case 'S': case 'e': case 'E':
+    case 'a': case 'A': case 'T': case 'F': case 'u': case 'U':
+      break;
+    default:
+      basic_mud_log("SYSERR: Illegal $-code to act(): %c", *c);
+      basic_mud_log("SYSERR: %s", c);
+      if (*c)
+	c++;
+      continue;
+    }
+    t.tokens.push_back({ *(c++), 0, 0 });
+  }
+}
+
+
+/* The compiled form of str, from the cache if we have seen it before. */
+static act_template &find_act(const char *str)
 {
-  const char *i = NULL;
-  char lbuf[MAX_STRING_LENGTH], *buf, *j;
+  auto seen = act_by_address.find(str);
+
+  if (seen != act_by_address.end() && seen->second->source == str)
+    return *seen->second;
+
+  bool boot_address = (seen != act_by_address.end() && seen->second->pinned);
+
+  auto known = act_templates.find(str);
+
+  if (known == act_templates.end()) {
+    if (act_templates.size() >= MAX_ACT_TEMPLATES + act_pinned) {
+      for (auto it = act_by_address.begin(); it != act_by_address.end(); )
+	it = (it->second->pinned ? ++it : act_by_address.erase(it));
+      for (auto it = act_templates.begin(); it != act_templates.end(); )
+	it = (it->second.pinned ? ++it : act_templates.erase(it));
+    }
+    known = act_templates.emplace(str, act_template()).first;
+    compile_act(str, known->second);
+  }
+
+  if (boot_address)
+    return known->second;	/* keep the address for its boot string */
+
+  act_by_address[str] = &known->second;
+  return known->second;
+}
+
+
+/*
+ * Compile a string that stays put, such as a combat message, for good.
+ * The boot stages that do this run side by side, so they take turns;
+ * act() itself is only ever called from the game loop.
+ */
+void precompile_act(const char *str)
+{
+  static std::mutex boot_lock;
+
+  if (!str || !*str)
+    return;
+
+  std::lock_guard<std::mutex> guard(boot_lock);
+  act_template &t = find_act(str);
+
+  if (!t.pinned) {
+    t.pinned = true;
+    act_pinned++;
+  }
+  act_by_address[str] = &t;
+}
+
+
+/*
+ * higher-level communication: the act() function.  Fills in a compiled
+ * act() string as 'to' would see it, into lbuf (MAX_STRING_LENGTH), and
+ * returns the length of the line.
+ */
+static size_t render_act(const act_template &t, struct char_data *ch, struct obj_data *obj,
+		const void *vict_obj, const struct char_data *to, char *lbuf)
+{
+  char *buf = lbuf, *end = lbuf + MAX_STRING_LENGTH - 3, *j;
   bool uppercasenext = FALSE;
 
-  buf = lbuf;
+  for (const act_token &tok : t.tokens) {
+    const char *i = NULL;
+    size_t len;
 
-  for (;;) {
-    if (*orig == '$') {
-      switch (*(++orig)) {
-      case 'n':
-	i = PERS(ch, to);
-	break;
-      case 'N':
-	CHECK_NULL(vict_obj, PERS((const struct char_data *) vict_obj, to));
-	break;
-      case 'm':
-	i = HMHR(ch);
-	break;
-      case 'M':
-	CHECK_NULL(vict_obj, HMHR((const struct char_data *) vict_obj));
-	break;
-      case 's':
-	i = HSHR(ch);
-	break;
-      case 'S':
-	CHECK_NULL(vict_obj, HSHR((const struct char_data *) vict_obj));
-	break;
-      case 'e':
-	i = HSSH(ch);
-	break;
-      case 'E':
-	CHECK_NULL(vict_obj, HSSH((const struct char_data *) vict_obj));
-	break;
-      case 'o':
-	CHECK_NULL(obj, OBJN(obj, to));
-	break;
-      case 'O':
-	CHECK_NULL(vict_obj, OBJN((const struct obj_data *) vict_obj, to));
-	break;
-      case 'p':
-	CHECK_NULL(obj, OBJS(obj, to));
-	break;
-      case 'P':
-	CHECK_NULL(vict_obj, OBJS((const struct obj_data *) vict_obj, to));
-	break;
-      case 'a':
-	CHECK_NULL(obj, SANA(obj));
-	break;
-      case 'A':
-	CHECK_NULL(vict_obj, SANA((const struct obj_data *) vict_obj));
-	break;
-      case 'T':
-	CHECK_NULL(vict_obj, (const char *) vict_obj);
-	break;
-      case 'F':
-	CHECK_NULL(vict_obj, fname((const char *) vict_obj));
-	break;
-      /* uppercase previous word */
-      case 'u':
-        for (j=buf; j > lbuf && !isspace((int) *(j-1)); j--);
-        if (j != buf)
-          *j = UPPER(*j);
-        i = "";
-        break;
-      /* uppercase next word */
-      case 'U':
-        uppercasenext = TRUE;
-        i = "";
-        break;
-      case '$':
-	i = "$";
-	break;
-      default:
-	basic_mud_log("SYSERR: Illegal $-code to act(): %c", *orig);
-	basic_mud_log("SYSERR: %s", orig);
-	i = "";
-	break;
-      }
-      while ((*buf = *(i++)))
-        {
-        if (uppercasenext && !isspace((int) *buf))
-          {
-          *buf = UPPER(*buf);
-          uppercasenext = FALSE;
-          }
-	buf++;
-        }
-      orig++;
-    } else if (!(*(buf++) = *(orig++))) {
+    switch (tok.code) {
+    case '\0':
+      i = t.text.data() + tok.start;
+      break;
+    case 'n':
+      i = PERS(ch, to);
+      break;
+    case 'N':
+      CHECK_NULL(vict_obj, PERS((const struct char_data *) vict_obj, to));
+      break;
+    case 'm':
+      i = HMHR(ch);
+      break;
+    case 'M':
+      CHECK_NULL(vict_obj, HMHR((const struct char_data *) vict_obj));
+      break;
+    case 's':
+      i = HSHR(ch);
+      break;
+    case 'S':
+      CHECK_NULL(vict_obj, HSHR((const struct char_data *) vict_obj));
+      break;
+    case 'e':
+      i = HSSH(ch);
+      break;
+    case 'E':
+      CHECK_NULL(vict_obj, HSSH((const struct char_data *) vict_obj));
+      break;
+    case 'o':
+      CHECK_NULL(obj, OBJN(obj, to));
       break;
-    } else if (uppercasenext && !isspace((int) *(buf-1))) {
-      *(buf-1) = UPPER(*(buf-1));
-      uppercasenext = FALSE;
+    case 'O':
+      CHECK_NULL(vict_obj, OBJN((const struct obj_data *) vict_obj, to));
+      break;
+    case 'p':
+      CHECK_NULL(obj, OBJS(obj, to));
+      break;
+    case 'P':
+      CHECK_NULL(vict_obj, OBJS((const struct obj_data *) vict_obj, to));
+      break;
+    case 'a':
+      CHECK_NULL(obj, SANA(obj));
+      break;
+    case 'A':
+      CHECK_NULL(vict_obj, SANA((const struct obj_data *) vict_obj));
+      break;
+    case 'T':
+      CHECK_NULL(vict_obj, (const char *) vict_obj);
+      break;
+    case 'F':
+      CHECK_NULL(vict_obj, fname((const char *) vict_obj));
+      break;
+    /* uppercase previous word */
+    case 'u':
+      for (j = buf; j > lbuf && !isspace((int) *(j-1)); j--);
+      if (j != buf)
+        *j = UPPER(*j);
+      continue;
+    /* uppercase next word */
+    case 'U':
+      uppercasenext = TRUE;
+      continue;
     }
+
+    len = (tok.code ? strlen(i) : tok.len);
+    if (len > static_cast<size_t>(end - buf))
+      len = end - buf;
+
+    for (; uppercasenext && len > 0; len--)
+      if (!isspace((int) (*(buf++) = *(i++)))) {
+        *(buf-1) = UPPER(*(buf-1));
+        uppercasenext = FALSE;
+      }
+
+    memcpy(buf, i, len);
+    buf += len;
   }
 
-  *(--buf) = '\r';
+  *buf = '\r';
   *(++buf) = '\n';
   *(++buf) = '\0';
 
-  write_to_output(to->desc, "%s", CAP(lbuf));
+  CAP(lbuf);
+  return (buf - lbuf);
+}
+
+
+static void send_act(const act_template &t, struct char_data *ch, struct obj_data *obj,
+		const void *vict_obj, const struct char_data *to)
+{
+  char lbuf[MAX_STRING_LENGTH];
+  size_t len = render_act(t, ch, obj, vict_obj, to, lbuf);
+
+  write_text_to_output(to->desc, lbuf, len);
+}
+
+
+void perform_act(const char *orig, struct char_data *ch, struct obj_data *obj,
+		const void *vict_obj, const struct char_data *to)
+{
+  send_act(find_act(orig), ch, obj, vict_obj, to);
+}
+
+
+/* Broadcasts are mostly one-off text; they are compiled, but not cached. */
+act_broadcast::act_broadcast(const char *str, struct char_data *ch, struct obj_data *obj,
+		const void *vict_obj, const char *color)
+  : _ch(ch), _obj(obj), _vict_obj(vict_obj), _color(color)
+{
+  compile_act(str, _template);
+}
+
+
+void act_broadcast::render(const struct char_data *to, bool color, std::string &txt) const
+{
+  char lbuf[MAX_STRING_LENGTH];
+  size_t len = render_act(_template, _ch, _obj, _vict_obj, to, lbuf);
+
+  txt.clear();
+  if (color)
+    txt.append(_color);
+  txt.append(lbuf, len);
+  if (color)
+    txt.append(KNRM);
+}
+
+
+void act_broadcast::send(const struct char_data *to)
+{
+  bool color = (_color && COLOR_LEV(to) >= C_NRM);
+
+  if (!to->desc)
+    return;
+
+  if (_template.per_listener) {
+    std::string txt;
+
+    render(to, color, txt);
+    write_text_to_output(to->desc, txt.data(), txt.size());
+    return;
+  }
+
+  int seen = (!_template.names_ch || CAN_SEE(to, _ch));
+  std::string &txt = _text[seen][color];
+
+  if (!_rendered[seen][color]) {
+    render(to, color, txt);
+    _rendered[seen][color] = true;
+  }
+  write_text_to_output(to->desc, txt.data(), txt.size());
 }
 
 
@@ -2384,6 +2929,8 @@ void act(const char *str, int hide_invisible, struct char_data *ch, struct obj_d
   if (!str || !*str)
     return;
 
+  const act_template &t = find_act(str);
+
   /*
    * Warning: the following CommTarget::TO_SLEEP code is a hack.
    * 
@@ -2401,13 +2948,13 @@ void act(const char *str, int hide_invisible, struct char_data *ch, struct obj_d
 
   if (type == CommTarget::TO_CHAR) {
     if (ch && SENDOK(ch))
-      perform_act(str, ch, obj, vict_obj, ch);
+      send_act(t, ch, obj, vict_obj, ch);
     return;
   }
 
   if (type == CommTarget::TO_VICT) {
     if ((to = (const struct char_data *) vict_obj) != NULL && SENDOK(to)) {
-      perform_act(str, ch, obj, vict_obj, to);
+      send_act(t, ch, obj, vict_obj, to);
     }
     return;
   }
@@ -2436,7 +2983,7 @@ void act(const char *str, int hide_invisible, struct char_data *ch, struct obj_d
     if (type != CommTarget::TO_ROOM && to == vict_obj) {
       continue;
     }
-    perform_act(str, ch, obj, vict_obj, to);
+    send_act(t, ch, obj, vict_obj, to);
   }
 }
 
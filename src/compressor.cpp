@@ -0,0 +1,255 @@
+/*
+ * compressor.cpp
+ *
+ * The worker pool behind compress_output().  Text handed over for a
+ * stream waits on that stream's own queue, and at most one worker drains
+ * a stream at a time, so its bytes come out in the order they went in.
+ * game_loop() picks them up once per pass through check_compressed_output().
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <zlib.h>
+
+#include "structs.h"
+#include "utils.h"
+#include "outbuf.h"
+#include "compressor.h"
+#include "worker_pool.h"
+
+struct compressor {
+  std::mutex lock;		/* guards everything but 'zs' and 'desc' */
+  z_stream zs;			/* only the worker draining us uses it	*/
+
+  struct out_segment *queued = nullptr;	/* waiting to be compressed	*/
+  struct out_segment **queued_tail = &queued;
+  bool draining = false;	/* a worker has (or is about to have) us */
+  std::condition_variable drained;	/* signalled when 'draining' ends */
+
+  std::string done;		/* compressed, not yet collected	*/
+  struct out_segment *spent = nullptr;	/* compressed, to be freed	*/
+  unsigned long long bytes_in = 0, bytes_out = 0;
+  double cpu_msec = 0;
+
+  struct descriptor_data *desc;	/* game thread only; NULL once gone	*/
+
+  compressor(struct descriptor_data *d) : desc(d)
+  {
+    memset(&zs, 0, sizeof(zs));
+    deflateInit(&zs, Z_DEFAULT_COMPRESSION);
+  }
+
+  ~compressor() { deflateEnd(&zs); }
+};
+
+typedef std::shared_ptr<struct compressor> compressor_ptr;
+
+static std::unique_ptr<worker_pool<compressor_ptr, compressor_ptr> > compressors;
+
+unsigned long long compress_bytes_in = 0, compress_bytes_out = 0;
+double compress_cpu_msec = 0;
+
+
+static double thread_cpu_msec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
+}
+
+
+/*
+ * Deflate one batch, ending with a sync flush so the client sees it all,
+ * or with Z_FINISH to end the stream.
+ */
+static void deflate_segments(z_stream &zs, const struct out_segment *list, std::string &out, int last = Z_SYNC_FLUSH)
+{
+  unsigned char chunk[8192];
+
+  for (const struct out_segment *seg = list; ; seg = seg->next) {
+    int flush = (seg ? Z_NO_FLUSH : last);
+
+    zs.next_in = (Bytef *) (seg ? seg->data + seg->start : nullptr);
+    zs.avail_in = (seg ? seg->end - seg->start : 0);
+
+    do {
+      zs.next_out = chunk;
+      zs.avail_out = sizeof(chunk);
+      deflate(&zs, flush);
+      out.append((const char *) chunk, sizeof(chunk) - zs.avail_out);
+    } while (zs.avail_out == 0);
+
+    if (!seg)
+      break;
+  }
+}
+
+
+static compressor_ptr drain_compressor(const compressor_ptr &c)
+{
+  std::unique_lock<std::mutex> guard(c->lock);
+
+  while (c->queued) {
+    struct out_segment *list = c->queued, **tail = c->queued_tail;
+    unsigned long long in = 0;
+    std::string out;
+
+    c->queued = nullptr;
+    c->queued_tail = &c->queued;
+    guard.unlock();
+
+    double start = thread_cpu_msec();
+
+    for (const struct out_segment *seg = list; seg; seg = seg->next)
+      in += seg->end - seg->start;
+    deflate_segments(c->zs, list, out);
+
+    double used = thread_cpu_msec() - start;
+
+    guard.lock();
+    c->done += out;
+    *tail = c->spent;
+    c->spent = list;
+    c->bytes_in += in;
+    c->bytes_out += out.size();
+    c->cpu_msec += used;
+  }
+  c->draining = false;
+  c->drained.notify_all();
+
+  return (c);
+}
+
+
+void init_compressors(int threads)
+{
+  compressors.reset(new worker_pool<compressor_ptr, compressor_ptr>(drain_compressor, threads));
+}
+
+
+/* Output still queued is abandoned; only happens at shutdown. */
+void shutdown_compressors(void)
+{
+  compressors.reset();
+}
+
+
+compressor_ptr start_compression(struct descriptor_data *d)
+{
+  return std::make_shared<compressor>(d);
+}
+
+
+void end_compression(compressor_ptr &c)
+{
+  if (!c)
+    return;
+
+  c->desc = nullptr;
+  c.reset();
+}
+
+
+void finish_compression(compressor_ptr &c, std::string &bytes)
+{
+  struct out_segment *spent;
+  size_t done;
+
+  if (!c)
+    return;
+
+  if (compressors) {
+    std::unique_lock<std::mutex> guard(c->lock);
+
+    /* Let the worker finish what it has; it's small, and it comes first. */
+    c->drained.wait(guard, [&c] { return !c->draining; });
+
+    bytes = std::move(c->done);
+    c->done.clear();
+    spent = c->spent;
+    c->spent = nullptr;
+
+    done = bytes.size();
+    deflate_segments(c->zs, nullptr, bytes, Z_FINISH);
+
+    compress_bytes_in += c->bytes_in;
+    compress_bytes_out += c->bytes_out + bytes.size() - done;
+    compress_cpu_msec += c->cpu_msec;
+    c->bytes_in = c->bytes_out = 0;
+    c->cpu_msec = 0;
+
+    guard.unlock();
+    free_segments(spent);
+  }
+
+  end_compression(c);
+}
+
+
+void compress_output(const compressor_ptr &c, out_chain &text)
+{
+  struct out_segment *list = text.release(), *last;
+  bool submit;
+
+  if (!list)
+    return;
+
+  for (last = list; last->next; last = last->next)
+    ;
+
+  {
+    std::lock_guard<std::mutex> guard(c->lock);
+
+    *c->queued_tail = list;
+    c->queued_tail = &last->next;
+    submit = !c->draining;
+    c->draining = true;
+  }
+
+  if (submit)
+    compressors->submit(c);
+}
+
+
+void wait_for_compressors(int msec)
+{
+  if (compressors && msec > 0)
+    compressors->wait_idle(std::chrono::milliseconds(msec));
+}
+
+
+bool collect_compressed_output(struct descriptor_data **d, std::string &bytes)
+{
+  unsigned long ticket;
+  compressor_ptr c;
+  struct out_segment *spent;
+
+  if (!compressors || !compressors->collect(ticket, c))
+    return (false);
+
+  {
+    std::lock_guard<std::mutex> guard(c->lock);
+
+    bytes = std::move(c->done);
+    c->done.clear();
+    spent = c->spent;
+    c->spent = nullptr;
+
+    compress_bytes_in += c->bytes_in;
+    compress_bytes_out += c->bytes_out;
+    compress_cpu_msec += c->cpu_msec;
+    c->bytes_in = c->bytes_out = 0;
+    c->cpu_msec = 0;
+  }
+
+  /* Segments only go back to their pool from this thread. */
+  free_segments(spent);
+  *d = c->desc;
+
+  return (true);
+}
@@ -83,6 +83,22 @@ int idle_max_level = LVL_GOD;
 /* should items in death traps automatically be junked? */
 bool dts_are_dumps = YES;
 
+/*
+ * Should mobiles in zones with no mortals playing in them skip wandering,
+ * scavenging and attacking until someone arrives?  Nobody is there to
+ * notice, and it saves the work for zones that matter.  Special
+ * procedures still run everywhere.
+ */
+bool idle_empty_zones = YES;
+
+/*
+ * How many zone reset commands may run each pulse.  A big zone then
+ * resets a piece at a time over several pulses instead of stalling the
+ * game for one; zones that are due queue up behind it.  Set this to 0 to
+ * reset each zone in one go, one zone per pulse.
+ */
+int zone_reset_budget = 100;
+
 /*
  * Whether you want items that immortals load to appear on the ground or not.
  * It is most likely best to set this to 'YES' so that something else doesn't
@@ -105,6 +121,14 @@ const std::string NOEFFECT = "Nothing seems to happen.\r\n";
  */
 bool track_through_doors = YES;
 
+/*
+ * Track remembers up to this many routes, so following a trail step by
+ * step, or tracking the same target again, doesn't search the world each
+ * time.  Opening or closing a door forgets them all when track can't go
+ * through doors.  Set this to 0 to always search.
+ */
+int route_cache_size = 8192;
+
 /*
  * If you want mortals to level up to immortal once they have enough
  * experience, then set this to 0.  This is the stock behaviour for
@@ -246,22 +270,41 @@ int max_bad_pws = 3;
 bool siteok_everyone = true;
 
 /*
- * Some nameservers are very slow and cause the game to lag terribly every 
- * time someone logs in.  The lag is caused by the gethostbyaddr() function
- * which is responsible for resolving numeric IP addresses to alphabetic names.
- * Sometimes, nameservers can be so slow that the incredible lag caused by
- * gethostbyaddr() isn't worth the luxury of having names instead of numbers
- * for players' sitenames.
+ * Numeric IP addresses are resolved to alphabetic names by a few resolver
+ * threads, so a slow nameserver no longer lags the game.  A new
+ * connection's name is not taken until its site's name comes back, or
+ * resolver_timeout seconds go by, so that select and new-character bans
+ * see the name; the ban list is checked against both.
  *
- * If your nameserver is fast, set the variable below to NO.  If your
- * nameserver is slow, of it you would simply prefer to have numbers
- * instead of names for some other reason, set the variable to YES.
- *
- * You can experiment with the setting of nameserver_is_slow on-line using
- * the SLOWNS command from within the MUD.
+ * If you would simply prefer to have numbers instead of names for
+ * players' sitenames, set nameserver_is_slow to YES and no lookups are
+ * made at all.  You can experiment with the setting of nameserver_is_slow
+ * on-line using the SLOWNS command from within the MUD.
  */
 
 bool nameserver_is_slow = NO;
+int resolver_threads = 2;
+int resolver_timeout = 10;
+
+/*
+ * Password checks at login, password change and self-delete are hashed by
+ * this many worker threads so that a deliberately slow crypt() never holds
+ * up the game.  The player waits at a "Verifying PW" state meanwhile.
+ */
+int crypt_threads = 2;
+
+/*
+ * Clients are offered MCCP v2 output compression when they connect, and
+ * the compressing is done by this many worker threads.  0 turns it off.
+ *
+ * Each pass of the game loop waits up to compress_wait_msec for the
+ * workers before it sends output, so compressed text goes out in the
+ * same pass as plain text.  Whatever isn't done by then goes out a pass
+ * (a tenth of a second) later.  0 never waits, and always costs MCCP
+ * clients that pass of latency.
+ */
+int compress_threads = 2;
+int compress_wait_msec = 10;
 
 
 const std::string MENU =
@@ -236,6 +236,7 @@ const char *connected_types[] = {
   "Self-Delete 1",
   "Self-Delete 2",
   "Disconnecting",
+  "Verifying PW",
   "\n"
 };
 
@@ -19,6 +19,9 @@
 #include <algorithm>
 #include <fstream>
 #include <streambuf>
+#include <unordered_map>
+#include <set>
+#include <climits>
 
 #include "structs.h"
 #include "utils.h"
@@ -40,22 +43,35 @@
 #include "config.h"
 #include "act.h"
 #include "ban.h"
+#include "vnum_index.h"
+#include "snapshot.h"
+#include "boot_pipeline.h"
+#include "graph.h"
+#include "timer_wheel.h"
+#include "simulate.h"
 
 /**************************************************************************
 *  declarations of most of the 'global' variables                         *
 **************************************************************************/
 
 std::vector<room_data> world;
-std::list<char_data *> character_list;
+char_list character_list;
 std::vector<index_data> mob_index;
 std::vector<char_data> mob_proto;
-std::list<obj_data *> object_list;
+obj_list object_list;
 std::vector<index_data> obj_index;
 std::vector<obj_data> obj_proto;
 std::vector<zone_data> zone_table;
 std::vector<message_list> fight_messages;	/* fighting messages	 */
 
+vnum_index room_vnums;		/* vnum -> rnum for world	 */
+vnum_index mob_vnums;		/* vnum -> rnum for mob_index	 */
+vnum_index obj_vnums;		/* vnum -> rnum for obj_proto	 */
+vnum_index zone_vnums;		/* vnum -> rnum for zone_table	 */
+
 std::vector<player_index_element> player_table;
+std::unordered_map<std::string, long> player_name_index; /* name -> ptable */
+std::unordered_map<long, long> player_id_index;	/* idnum -> ptable	 */
 FILE *player_fl = nullptr;		/* file desc of player file	 */
 long top_idnum = 0;		/* highest idnum in use		 */
 
@@ -87,7 +103,6 @@ std::vector<help_index_element> help_table;	/* the help table	 */
 struct time_info_data time_info;/* the infomation about the time    */
 struct weather_data weather_info;	/* the infomation about the weather */
 struct player_special_data dummy_mob;	/* dummy spec area for mobs	*/
-struct reset_q_type reset_q;	/* queue of zones to be reset	 */
 
 /* local functions */
 int check_bitvector_names(bitvector_t bits, size_t namecount, const char *whatami, const char *whatbits);
@@ -232,33 +247,10 @@ ACMD(do_reboot)
 }
 
 
-void boot_world(void)
+/* Build the rnum lookups and index tables for freshly loaded prototypes. */
+static void index_objects(void)
 {
-  basic_mud_log("Started future loading zone table.");
-  zone_future z(mini_mud);
-  z.parse();
-
-  basic_mud_log("Started future loading objs and generating index.");
-  object_future o(mini_mud);
-  o.parse();
-
-  // can start mob and shop parsing here when done
-
-  basic_mud_log("Waiting for completion of zone loading...");
-  zone_table = z.items();
-  basic_mud_log("   %lu zones, %lu bytes.", zone_table.size(), zone_table.size() * sizeof(zone_data));
-
-  std::for_each(zone_table.begin(), zone_table.end(), [](zone_data z) {
-      basic_mud_log("Zone %s (%d): bot: %d, top: %d", z.name.c_str(), z.number, z.bot, z.top);
-    });
-
-  // Okay to start room parsing here
-  basic_mud_log("Started future loading rooms.");
-  room_future r(mini_mud);
-  r.parse();
-
-  basic_mud_log("Waiting for completion of object loading ... then building index.");
-  obj_proto = o.items();
+  obj_vnums.build(obj_proto, [](const obj_data &o) { return o.vnum; });
 
   std::for_each(obj_proto.begin(), obj_proto.end(), [](const obj_data &o) {
       index_data oi;
@@ -268,26 +260,11 @@ void boot_world(void)
       obj_index.push_back(oi);
     });
   basic_mud_log("   %ld objs, %lu bytes in index, %lu bytes in prototypes.", obj_proto.size(), obj_proto.size() * sizeof(index_data), obj_proto.size() * sizeof(obj_data));
+}
 
-  // get rooms.  
-  basic_mud_log("Waiting for completion of room loading...");
-  world = r.items();
-  basic_mud_log("   %ld rooms, %lu bytes.", world.size(), world.size() * sizeof(room_data));
-
-  basic_mud_log("Renumbering rooms.");
-  renum_world();
-
-  basic_mud_log("Checking start rooms.");
-  check_start_rooms();
-
-  // can wait for all other fuqture based parses to complete. 
-  basic_mud_log("Startinf future parsing of mobs and generating index.");
-  mob_future mobs(mini_mud);
-  mobs.parse();
-
-  basic_mud_log("Waiting for completion of mob loading...");
-  mob_proto = mobs.items();
 
+static void index_mobiles(void)
+{
   std::for_each(mob_proto.begin(), mob_proto.end(), [](const char_data &m) {
       index_data mi;
       mi.vnum = m.vnr;
@@ -295,19 +272,116 @@ void boot_world(void)
       mi.func = nullptr;
       mob_index.push_back(mi);
     });
+  mob_vnums.build(mob_index, [](const index_data &m) { return m.vnum; });
 
   basic_mud_log("   %ld mobiles, %lu bytes.", mob_proto.size(), mob_proto.size() * sizeof(char_data));
+}
+
+
+/*
+ * A world snapshot holds the tables exactly as the parse below leaves them,
+ * renumbered and all, so only the indexes need building again.  A syntax
+ * check always reads the world files, that being the point of it.
+ */
+static bool boot_world_snapshot(void)
+{
+  if (scheck || !load_world_snapshot(mini_mud, !no_specials))
+    return (false);
 
+  basic_mud_log("Loaded world from snapshot.");
+  zone_vnums.build(zone_table, [](const zone_data &z) { return z.number; });
+  basic_mud_log("   %lu zones, %lu bytes.", zone_table.size(), zone_table.size() * sizeof(zone_data));
+  room_vnums.build(world, [](const room_data &r) { return r.number; });
+  basic_mud_log("   %ld rooms, %lu bytes.", world.size(), world.size() * sizeof(room_data));
+  index_objects();
+  index_mobiles();
+
+  basic_mud_log("Checking start rooms.");
+  check_start_rooms();
+
+  return (true);
+}
 
-  basic_mud_log("Renumbering zone table.");
-  renum_zone_table();
 
-  if (!no_specials) {
+/*
+ * The loaders only wait on what they really use: rooms need the zone
+ * table to place themselves, renumbering needs the vnum indexes of
+ * whatever it resolves, and shops look up their keepers and goods.
+ */
+void boot_world(void)
+{
+  boot_pipeline pipeline("World boot");
+  size_t zones, objs, rooms, mobs, renum_rooms, renum_zones, shops;
+
+  if (boot_world_snapshot())
+    return;
+
+  zones = pipeline.add("zones", {}, [] {
+    basic_mud_log("Loading zone table.");
+    zone_future z(mini_mud);
+    z.parse();
+    zone_table = z.items();
+    zone_vnums.build(zone_table, [](const zone_data &z) { return z.number; });
+    basic_mud_log("   %lu zones, %lu bytes.", zone_table.size(), zone_table.size() * sizeof(zone_data));
+
+    std::for_each(zone_table.begin(), zone_table.end(), [](zone_data z) {
+	basic_mud_log("Zone %s (%d): bot: %d, top: %d", z.name.c_str(), z.number, z.bot, z.top);
+      });
+  });
+
+  objs = pipeline.add("objects", {}, [] {
+    basic_mud_log("Loading objs and generating index.");
+    object_future o(mini_mud);
+    o.parse();
+    obj_proto = o.items();
+    index_objects();
+  });
+
+  rooms = pipeline.add("rooms", { zones }, [] {
+    basic_mud_log("Loading rooms.");
+    room_future r(mini_mud);
+    r.parse();
+    world = r.items();
+    room_vnums.build(world, [](const room_data &r) { return r.number; });
+    basic_mud_log("   %ld rooms, %lu bytes.", world.size(), world.size() * sizeof(room_data));
+  });
+
+  mobs = pipeline.add("mobiles", {}, [] {
+    basic_mud_log("Loading mobs and generating index.");
+    mob_future m(mini_mud);
+    m.parse();
+    mob_proto = m.items();
+    index_mobiles();
+  });
+
+  renum_rooms = pipeline.add("renumber rooms", { rooms }, [] {
+    basic_mud_log("Renumbering rooms.");
+    renum_world();
+
+    basic_mud_log("Checking start rooms.");
+    check_start_rooms();
+  });
+
+  renum_zones = pipeline.add("renumber zone table", { zones, rooms, objs, mobs }, [] {
+    basic_mud_log("Renumbering zone table.");
+    renum_zone_table();
+  });
+
+  shops = pipeline.add("shops", { objs, mobs }, [] {
+    if (no_specials)
+      return;
     basic_mud_log("Loading shops.");
     shop_future s(mini_mud);
     s.parse();
     shop_index = s.items();
-  }
+  });
+
+  pipeline.add("snapshot", { renum_rooms, renum_zones, shops }, [] {
+    basic_mud_log("Writing world snapshot.");
+    save_world_snapshot(mini_mud, !no_specials);
+  });
+
+  pipeline.run();
 }
 
 /* Free the world, in a memory allocation sense. */
@@ -320,52 +394,76 @@ void destroy_db(void)
 }
 
 
-/* body of the booting system */
+/*
+ * body of the booting system
+ *
+ * Stages that share nothing run side by side; the ones that need the
+ * world, the spells or the player index say so.  Zone resets go last,
+ * once houses have put their objects down.  The random number generator
+ * is unlocked, and only "game time" (the weather) and "zone resets" (new
+ * mobiles) draw from it, so resets also wait for the time: the numbers
+ * come out in the old serial order, and a fixed seed boots the same way.
+ */
 void boot_db(void)
 {
-  zone_rnum i;
+  boot_pipeline pipeline("Boot db");
+  size_t game_time, spells, world, players, specials, houses;
 
   basic_mud_log("Boot db -- BEGIN.");
 
-  basic_mud_log("Resetting the game time:");
-  reset_time();
-
-  basic_mud_log("Reading news, credits, help, bground, info & motds.");
-  
-  news = slurp_file_to_string(NEWS_FILE);
-  credits = slurp_file_to_string(CREDITS_FILE);
-  motd = slurp_file_to_string(MOTD_FILE);
-  imotd = slurp_file_to_string(IMOTD_FILE);
-  help = slurp_file_to_string(HELP_PAGE_FILE);
-  info = slurp_file_to_string(INFO_FILE);
-  wizlist = slurp_file_to_string(WIZLIST_FILE);
-  immlist = slurp_file_to_string(IMMLIST_FILE);
-  policies = slurp_file_to_string(POLICIES_FILE);
-  handbook = slurp_file_to_string(HANDBOOK_FILE);
-  background = slurp_file_to_string(BACKGROUND_FILE);
-  GREETINGS = slurp_file_to_string(GREETINGS_FILE);
-  prune_crlf(GREETINGS);
-
-  basic_mud_log("Loading spell definitions.");
-  mag_assign_spells();
+  game_time = pipeline.add("game time", {}, [] {
+    basic_mud_log("Resetting the game time:");
+    reset_time();
+  });
 
-  boot_world();
-
-  basic_mud_log("Loading help entries.");
-  help_boot();
-
-  basic_mud_log("Generating player index.");
-  build_player_index();
-
-  basic_mud_log("Loading fight messages.");
-  load_messages();
+  pipeline.add("text files", {}, [] {
+    basic_mud_log("Reading news, credits, help, bground, info & motds.");
+    news = slurp_file_to_string(NEWS_FILE);
+    credits = slurp_file_to_string(CREDITS_FILE);
+    motd = slurp_file_to_string(MOTD_FILE);
+    imotd = slurp_file_to_string(IMOTD_FILE);
+    help = slurp_file_to_string(HELP_PAGE_FILE);
+    info = slurp_file_to_string(INFO_FILE);
+    wizlist = slurp_file_to_string(WIZLIST_FILE);
+    immlist = slurp_file_to_string(IMMLIST_FILE);
+    policies = slurp_file_to_string(POLICIES_FILE);
+    handbook = slurp_file_to_string(HANDBOOK_FILE);
+    background = slurp_file_to_string(BACKGROUND_FILE);
+    GREETINGS = slurp_file_to_string(GREETINGS_FILE);
+    prune_crlf(GREETINGS);
+  });
 
-  basic_mud_log("Loading social messages.");
-  boot_social_messages();
+  spells = pipeline.add("spells", {}, [] {
+    basic_mud_log("Loading spell definitions.");
+    mag_assign_spells();
+  });
 
-  basic_mud_log("Assigning function pointers:");
+  world = pipeline.add("world", {}, boot_world);
 
-  if (!no_specials) {
+  pipeline.add("help", {}, [] {
+    basic_mud_log("Loading help entries.");
+    help_boot();
+  });
+
+  players = pipeline.add("player index", {}, [] {
+    basic_mud_log("Generating player index.");
+    build_player_index();
+  });
+
+  pipeline.add("fight messages", {}, [] {
+    basic_mud_log("Loading fight messages.");
+    load_messages();
+  });
+
+  pipeline.add("socials", {}, [] {
+    basic_mud_log("Loading social messages.");
+    boot_social_messages();
+  });
+
+  specials = pipeline.add("special procedures", { world }, [] {
+    if (no_specials)
+      return;
+    basic_mud_log("Assigning function pointers:");
     basic_mud_log("   Mobiles.");
     assign_mobiles();
     basic_mud_log("   Shopkeepers.");
@@ -374,42 +472,58 @@ void boot_db(void)
     assign_objects();
     basic_mud_log("   Rooms.");
     assign_rooms();
-  }
-
-  basic_mud_log("Assigning spell and skill levels.");
-  init_spell_levels();
-
-  basic_mud_log("Sorting command list and spells.");
-  sort_commands();
-  sort_spells();
+  });
+
+  pipeline.add("spell levels", { spells }, [] {
+    basic_mud_log("Assigning spell and skill levels.");
+    init_spell_levels();
+    sort_spells();
+  });
+
+  pipeline.add("commands", {}, [] {
+    basic_mud_log("Sorting command list.");
+    sort_commands();
+    build_command_trie();
+  });
+
+  pipeline.add("mail", {}, [] {
+    basic_mud_log("Booting mail system.");
+    if (!scan_file()) {
+      basic_mud_log("    Mail boot failed -- Mail system disabled");
+      no_mail = 1;
+    }
+  });
 
-  basic_mud_log("Booting mail system.");
-  if (!scan_file()) {
-    basic_mud_log("    Mail boot failed -- Mail system disabled");
-    no_mail = 1;
-  }
-  basic_mud_log("Reading banned site and invalid-name list.");
-  load_banned();
-  read_invalid_list();
+  pipeline.add("bans", {}, [] {
+    basic_mud_log("Reading banned site and invalid-name list.");
+    load_banned();
+    read_invalid_list();
+  });
 
-  if (!no_rent_check) {
+  pipeline.add("rent files", { players }, [] {
+    if (no_rent_check)
+      return;
     basic_mud_log("Deleting timed-out crash and rent files:");
     update_obj_file();
     basic_mud_log("   Done.");
-  }
+  });
 
   /* Moved here so the object limit code works. -gg 6/24/98 */
-  if (!mini_mud) {
+  houses = pipeline.add("houses", { world, players }, [] {
+    if (mini_mud)
+      return;
     basic_mud_log("Booting houses.");
     House_boot();
-  }
+  });
 
-  for (i = 0; static_cast<unsigned long>(i) < zone_table.size(); i++) {
-    basic_mud_log("Resetting #%d: %s (rooms %d-%d).", zone_table[i].number, zone_table[i].name.c_str(), zone_table[i].bot, zone_table[i].top);
-    reset_zone(i);
-  }
+  pipeline.add("zone resets", { game_time, world, specials, houses }, [] {
+    for (zone_rnum i = 0; static_cast<unsigned long>(i) < zone_table.size(); i++) {
+      basic_mud_log("Resetting #%d: %s (rooms %d-%d).", zone_table[i].number, zone_table[i].name.c_str(), zone_table[i].bot, zone_table[i].top);
+      reset_zone(i);
+    }
+  });
 
-  reset_q.head = reset_q.tail = NULL;
+  pipeline.run();
 
   boot_time = time(0);
 
@@ -432,7 +546,8 @@ void reset_time(void)
   if (beginning_of_time == 0)
     beginning_of_time = 650336715;
 
-  time_info = *mud_time_passed(time(0), beginning_of_time);
+  /* A simulation always starts at the beginning of time. */
+  time_info = *mud_time_passed(sim_pulses ? beginning_of_time : time(0), beginning_of_time);
 
   if (time_info.hours <= 4)
     weather_info.sunlight = SUN_DARK;
@@ -487,6 +602,29 @@ void free_player_index(void)
     return;
 
   player_table.clear();
+  player_name_index.clear();
+  player_id_index.clear();
+}
+
+
+/*
+ * Lowercase copy of a player name, the form it has in player_table and
+ * in player_name_index.
+ */
+static std::string player_key(const char *name)
+{
+  std::string key(name);
+
+  std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c){ return std::tolower(c); });
+  return key;
+}
+
+
+/* Duplicates keep the first entry, as the old linear searches did. */
+static void index_player_id(long pos)
+{
+  if (player_table[pos].id > 0)
+    player_id_index.emplace(player_table[pos].id, pos);
 }
 
 
@@ -532,17 +670,12 @@ void build_player_index(void)
     /* new record */
     nr++;
     player_table.push_back(player_index_element());    
-    player_table[nr].name = std::string(dummy.name);
-
-    basic_mud_log("Name before: %s",player_table[nr].name.c_str());
-
-    std::transform(player_table[nr].name.begin(), player_table[nr].name.end(), player_table[nr].name.begin(), [](unsigned char c){ return std::tolower(c); });
-
-//    std::for_each(player_table[nr].name.begin(), player_table[nr].name.end(), [](unsigned char &ch) { return (ch =  std::tolower(ch)); });
-    basic_mud_log("Name after: %s",player_table[nr].name.c_str());
-
+    player_table[nr].name = player_key(dummy.name);
     player_table[nr].id = dummy.char_specials_saved.idnum;
     top_idnum = std::max(top_idnum, dummy.char_specials_saved.idnum);
+
+    player_name_index.emplace(player_table[nr].name, nr);
+    index_player_id(nr);
   }
 }
 
@@ -871,6 +1004,61 @@ int vnum_object(char *searchname, struct char_data *ch)
 }
 
 
+/*
+ * Characters and objects come and go by the thousand, so they have pools
+ * of their own instead of the general heap.  The pools are never freed;
+ * see slab_pool.h.
+ */
+static slab_pool &char_pool(void)
+{
+  static slab_pool *pool = new slab_pool("characters", sizeof(char_data), alignof(char_data));
+
+  return *pool;
+}
+
+
+static slab_pool &obj_pool(void)
+{
+  static slab_pool *pool = new slab_pool("objects", sizeof(obj_data), alignof(obj_data));
+
+  return *pool;
+}
+
+
+void *char_data::operator new(size_t size)
+{
+  if (size != sizeof(char_data))
+    return ::operator new(size);
+  return char_pool().allocate();
+}
+
+
+void char_data::operator delete(void *p, size_t size)
+{
+  if (size != sizeof(char_data))
+    ::operator delete(p);
+  else
+    char_pool().deallocate(p);
+}
+
+
+void *obj_data::operator new(size_t size)
+{
+  if (size != sizeof(obj_data))
+    return ::operator new(size);
+  return obj_pool().allocate();
+}
+
+
+void obj_data::operator delete(void *p, size_t size)
+{
+  if (size != sizeof(obj_data))
+    ::operator delete(p);
+  else
+    obj_pool().deallocate(p);
+}
+
+
 /* create a character, and add it to the char list */
 struct char_data *create_char(void)
 {
@@ -883,6 +1071,10 @@ struct char_data *create_char(void)
 }
 
 
+/* Numbers the mobiles and objects made from prototypes, never twice. */
+static unsigned long last_serial = 0;
+
+
 /* create a new mobile from a prototype */
 struct char_data *read_mobile(mob_vnum nr, int type) /* and mob_rnum */
 {
@@ -900,7 +1092,8 @@ struct char_data *read_mobile(mob_vnum nr, int type) /* and mob_rnum */
   mob = new char_data;
   clear_char(mob);
   *mob = mob_proto[i];
-  character_list.push_back(mob);
+  mob->serial = ++last_serial;
+  mob->list_pos = character_list.insert(character_list.end(), mob);
 
   if (!mob->points.max_hit) {
     mob->points.max_hit = dice(mob->points.hit, mob->points.mana) +
@@ -917,6 +1110,8 @@ struct char_data *read_mobile(mob_vnum nr, int type) /* and mob_rnum */
   mob->player.time.logon = time(0);
 
   mob_index[i].number++;
+  mob->proto_pos = mob_index[i].mobiles.insert(mob_index[i].mobiles.end(), mob);
+  start_point_update(mob);
 
   return (mob);
 }
@@ -953,10 +1148,15 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
   clear_object(obj);
 
   *obj = obj_proto[i];
+  obj->serial = ++last_serial;
 
   object_list.push_back(obj);
 
   obj_index[i].number++;
+  obj->proto_pos = obj_index[i].objects.insert(obj_index[i].objects.end(), obj);
+
+  if (IS_CORPSE(obj))
+    start_corpse_decay(obj);
 
   return (obj);
 }
@@ -965,11 +1165,49 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
 
 #define ZO_DEAD  999
 
-/* update zone ages, queue for reset if necessary, and dequeue when possible */
+/*
+ * Zones waiting to reset, in the order they asked.  Each zone keeps its
+ * ticket in zone_table[].reset_ticket, so it can be taken out of the line
+ * from anywhere without a search.
+ */
+static std::set<std::pair<unsigned long, zone_rnum> > reset_queue;
+static unsigned long last_reset_ticket = 0;
+
+/* A zone reset that may be spread over several pulses. */
+struct reset_state {
+  zone_rnum zone = NOWHERE;
+  unsigned int cmd_no = 0;
+  unsigned int last_cmd = 0;
+  struct char_data *mob = nullptr;	/* the last mobile 'M' loaded	*/
+  unsigned long mob_serial = 0;
+  mob_rnum mob_nr = NOBODY;
+  bool mob_gone = false;		/* ...and it died while we waited */
+  /* What this reset has loaded so far, newest of each kind, for 'P'. */
+  std::unordered_map<obj_rnum, std::pair<struct obj_data *, unsigned long> > loaded;
+};
+
+static struct reset_state resetting;	/* the queued reset under way	*/
+
+
+static void enqueue_reset(zone_rnum zone)
+{
+  zone_table[zone].reset_ticket = ++last_reset_ticket;
+  reset_queue.insert(std::make_pair(zone_table[zone].reset_ticket, zone));
+}
+
+
+static void dequeue_reset(zone_rnum zone)
+{
+  reset_queue.erase(std::make_pair(zone_table[zone].reset_ticket, zone));
+  zone_table[zone].reset_ticket = 0;
+}
+
+
+/* update zone ages, queue for reset if necessary */
 void zone_update(void)
 {
+  sim_stopwatch timing(SIM_ZONE_UPDATE);
   int i;
-  struct reset_q_element *update_u, *temp;
   static int timer = 0;
 
   /* jelson 10/22/92 */
@@ -990,49 +1228,80 @@ void zone_update(void)
 
       if (zone_table[i].age >= zone_table[i].lifespan &&
 	  zone_table[i].age < ZO_DEAD && zone_table[i].reset_mode) {
-	/* enqueue zone */
-
-  update_u = new reset_q_element;
-
-	update_u->zone_to_reset = i;
-	update_u->next = 0;
-
-	if (!reset_q.head)
-	  reset_q.head = reset_q.tail = update_u;
-	else {
-	  reset_q.tail->next = update_u;
-	  reset_q.tail = update_u;
-	}
-
+	enqueue_reset(i);
 	zone_table[i].age = ZO_DEAD;
       }
     }
   }	/* end - one minute has passed */
+}
 
 
-  /* dequeue zones (if possible) and reset */
-  /* this code is executed every 10 seconds (i.e. PULSE_ZONE) */
-  for (update_u = reset_q.head; update_u; update_u = update_u->next)
-    if (zone_table[update_u->zone_to_reset].reset_mode == 2 ||
-	is_empty(update_u->zone_to_reset)) {
-      reset_zone(update_u->zone_to_reset);
-      mudlog(CMP, LVL_GOD, FALSE, "Auto zone reset: %s", zone_table[update_u->zone_to_reset].name.c_str());
-      /* dequeue */
-      if (update_u == reset_q.head)
-	reset_q.head = reset_q.head->next;
-      else {
-	for (temp = reset_q.head; temp->next != update_u;
-	     temp = temp->next);
-
-	if (!update_u->next)
-	  reset_q.tail = temp;
-
-	temp->next = update_u->next;
-      }
+/*
+ * Anything a paused reset was holding on to may have been killed or
+ * junked since.  Only pointers are compared until they are known to be
+ * live, so nothing freed is ever looked at.  A live pointer isn't enough,
+ * though: the slab pools hand a freed slot straight to the next instance,
+ * which may well be of the same prototype.  So the serial has to match.
+ */
+static void recheck_reset(struct reset_state &rs)
+{
+  if (rs.mob && !rs.mob_gone) {
+    const char_list &mobs = mob_index[rs.mob_nr].mobiles;
 
-      free(update_u);
-      break;
-    }
+    if (std::find(mobs.begin(), mobs.end(), rs.mob) == mobs.end() ||
+	rs.mob->serial != rs.mob_serial || MOB_FLAGGED(rs.mob, MOB_NOTDEADYET))
+      rs.mob_gone = true;
+  }
+
+  for (auto it = rs.loaded.begin(); it != rs.loaded.end(); ) {
+    const obj_list &objs = obj_index[it->first].objects;
+
+    if (std::find(objs.begin(), objs.end(), it->second.first) == objs.end() ||
+	it->second.first->serial != it->second.second)
+      it = rs.loaded.erase(it);
+    else
+      ++it;
+  }
+}
+
+
+static bool run_reset(struct reset_state &rs, int &budget);
+
+/*
+ * Called every pulse: carry on with the zone being reset, and start on
+ * the next ones in the queue that may reset now, until this pulse has
+ * run zone_reset_budget commands.  With no budget, one whole zone is
+ * reset per pulse.
+ */
+void continue_zone_resets(void)
+{
+  sim_stopwatch timing(SIM_ZONE_RESETS);
+  int budget = (zone_reset_budget > 0 ? zone_reset_budget : INT_MAX);
+
+  while (budget > 0) {
+    if (resetting.zone == NOWHERE) {
+      auto next = std::find_if(reset_queue.begin(), reset_queue.end(),
+		[](const std::pair<unsigned long, zone_rnum> &q) {
+		  return (zone_table[q.second].reset_mode == 2 || is_empty(q.second));
+		});
+
+      if (next == reset_queue.end())
+	return;
+
+      resetting = reset_state();
+      resetting.zone = next->second;
+      dequeue_reset(resetting.zone);
+    } else
+      recheck_reset(resetting);
+
+    if (!run_reset(resetting, budget))
+      return;			/* paused until next pulse */
+
+    mudlog(CMP, LVL_GOD, FALSE, "Auto zone reset: %s", zone_table[resetting.zone].name.c_str());
+    resetting.zone = NOWHERE;
+    if (zone_reset_budget <= 0)
+      return;
+  }
 }
 
 void log_zone_error(zone_rnum zone, int cmd_no, const char *message)
@@ -1045,14 +1314,48 @@ void log_zone_error(zone_rnum zone, int cmd_no, const char *message)
 #define ZONE_ERROR(message) \
 	{ log_zone_error(zone, cmd_no, message); last_cmd = 0; }
 
-/* execute the reset command table of a given zone */
+/* execute the whole reset command table of a given zone, right now */
 void reset_zone(zone_rnum zone)
 {
-  unsigned int cmd_no, last_cmd = 0;
-  struct char_data *mob = NULL;
+  struct reset_state rs;
+  int budget = INT_MAX;
+
+  /* This does the job of any queued or half-done reset of the zone. */
+  if (resetting.zone == zone)
+    resetting.zone = NOWHERE;
+  if (zone_table[zone].reset_ticket)
+    dequeue_reset(zone);
+
+  rs.zone = zone;
+  run_reset(rs, budget);
+}
+
+
+/*
+ * Where a reset may stop for the pulse: an unconditional command that
+ * starts something new.  No if_flag chain is ever split, so a mobile and
+ * what it is given or wears are loaded in the same pulse.
+ */
+#define RESET_CAN_PAUSE(c) (!(c).if_flag && strchr("MODR*", (c).command))
+
+/*
+ * Execute the reset command table of rs.zone from where rs left off,
+ * spending budget on each command.  Returns FALSE if it ran out and
+ * stopped early; rs then holds what is needed to carry on.
+ */
+static bool run_reset(struct reset_state &rs, int &budget)
+{
+  zone_rnum zone = rs.zone;
+  unsigned int &cmd_no = rs.cmd_no, &last_cmd = rs.last_cmd;
+  struct char_data *&mob = rs.mob;
+  std::unordered_map<obj_rnum, std::pair<struct obj_data *, unsigned long> > &loaded = rs.loaded;
   struct obj_data *obj, *obj_to;
 
-  for (cmd_no = 0; cmd_no < zone_table[zone].cmd.size(); cmd_no++) {
+  for (; cmd_no < zone_table[zone].cmd.size(); cmd_no++) {
+
+    if (budget <= 0 && RESET_CAN_PAUSE(ZCMD))
+      return (false);
+    budget--;
 
     if (ZCMD.if_flag && !last_cmd)
       continue;
@@ -1070,6 +1373,9 @@ void reset_zone(zone_rnum zone)
     case 'M':			/* read a mobile */
       if (mob_index[ZCMD.arg1].number < ZCMD.arg2) {
 	mob = read_mobile(ZCMD.arg1, REAL);
+	rs.mob_serial = mob->serial;
+	rs.mob_nr = ZCMD.arg1;
+	rs.mob_gone = false;
 	char_to_room(mob, ZCMD.arg3);
 	last_cmd = 1;
       } else
@@ -1087,19 +1393,24 @@ void reset_zone(zone_rnum zone)
 	  IN_ROOM(obj) = NOWHERE;
 	  last_cmd = 1;
 	}
+	loaded[ZCMD.arg1] = std::make_pair(obj, obj->serial);
       } else
 	last_cmd = 0;
       break;
 
     case 'P':			/* object to object */
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
-	obj = read_object(ZCMD.arg1, REAL);
-	if (!(obj_to = get_obj_num(ZCMD.arg3))) {
+	/* Prefer the container this reset just made to the oldest one around. */
+	if (loaded.count(ZCMD.arg3))
+	  obj_to = loaded[ZCMD.arg3].first;
+	else if (!(obj_to = get_obj_num(ZCMD.arg3))) {
 	  ZONE_ERROR("target obj not found, command disabled");
 	  ZCMD.command = '*';
 	  break;
 	}
+	obj = read_object(ZCMD.arg1, REAL);
 	obj_to_obj(obj, obj_to);
+	loaded[ZCMD.arg1] = std::make_pair(obj, obj->serial);
 	last_cmd = 1;
       } else
 	last_cmd = 0;
@@ -1111,9 +1422,14 @@ void reset_zone(zone_rnum zone)
 	ZCMD.command = '*';
 	break;
       }
+      if (rs.mob_gone) {
+	last_cmd = 0;
+	break;
+      }
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
 	obj = read_object(ZCMD.arg1, REAL);
 	obj_to_char(obj, mob);
+	loaded[ZCMD.arg1] = std::make_pair(obj, obj->serial);
 	last_cmd = 1;
       } else
 	last_cmd = 0;
@@ -1125,12 +1441,17 @@ void reset_zone(zone_rnum zone)
 	ZCMD.command = '*';
 	break;
       }
+      if (rs.mob_gone) {
+	last_cmd = 0;
+	break;
+      }
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
 	if (ZCMD.arg3 < 0 || ZCMD.arg3 >= NUM_WEARS) {
 	  ZONE_ERROR("invalid equipment pos number");
 	} else {
 	  obj = read_object(ZCMD.arg1, REAL);
 	  equip_char(mob, obj, ZCMD.arg3);
+	  loaded[ZCMD.arg1] = std::make_pair(obj, obj->serial);
 	  last_cmd = 1;
 	}
       } else
@@ -1140,6 +1461,7 @@ void reset_zone(zone_rnum zone)
     case 'R': /* rem obj from room */
       if ((obj = get_obj_in_list_num(ZCMD.arg2, world[ZCMD.arg1].contents)) != NULL) {
         extract_obj(obj);
+        loaded.clear();	/* it may have been, or held, one of ours */
       }
       last_cmd = 1;
       break;
@@ -1150,7 +1472,9 @@ void reset_zone(zone_rnum zone)
 	  (!std::get<1>(world[ZCMD.arg1].dir_option[ZCMD.arg2]))) {
 	ZONE_ERROR("door does not exist, command disabled");
 	ZCMD.command = '*';
-      } else
+      } else {
+	int was_closed = IS_SET(std::get<0>(world[ZCMD.arg1].dir_option[ZCMD.arg2]).exit_info, EX_CLOSED);
+
 	switch (ZCMD.arg3) {
 	case 0:
 	  REMOVE_BIT(std::get<0>(world[ZCMD.arg1].dir_option[ZCMD.arg2]).exit_info, EX_LOCKED);
@@ -1165,6 +1489,10 @@ void reset_zone(zone_rnum zone)
 	  SET_BIT(std::get<0>(world[ZCMD.arg1].dir_option[ZCMD.arg2]).exit_info, EX_CLOSED);
 	  break;
 	}
+	/* Most resets find the door as they left it; only a change matters. */
+	if (was_closed != IS_SET(std::get<0>(world[ZCMD.arg1].dir_option[ZCMD.arg2]).exit_info, EX_CLOSED))
+	  door_changed();
+      }
       last_cmd = 1;
       break;
 
@@ -1176,6 +1504,7 @@ void reset_zone(zone_rnum zone)
   }
 
   zone_table[zone].age = 0;
+  return (true);
 }
 
 
@@ -1183,22 +1512,7 @@ void reset_zone(zone_rnum zone)
 /* for use in reset_zone; return TRUE if zone 'nr' is free of PC's  */
 int is_empty(zone_rnum zone_nr)
 {
-  struct descriptor_data *i;
-
-  for (i = descriptor_list; i; i = i->next) {
-    if (STATE(i) != CON_PLAYING)
-      continue;
-    if (IN_ROOM(i->character) == NOWHERE)
-      continue;
-    if (GET_LEVEL(i->character) >= LVL_IMMORT)
-      continue;
-    if (world[IN_ROOM(i->character)].zone != zone_nr)
-      continue;
-
-    return (0);
-  }
-
-  return (1);
+  return (zone_table[zone_nr].players == 0);	/* see update_zone_players() */
 }
 
 
@@ -1212,37 +1526,25 @@ int is_empty(zone_rnum zone_nr)
 
 long get_ptable_by_name(const char *name)
 {
-  unsigned int i;
-
-  for (i = 0; i < player_table.size(); i++)
-    if (!str_cmp(player_table[i].name.c_str(), name))
-      return i;
+  auto found = player_name_index.find(player_key(name));
 
-  return -1;
+  return (found == player_name_index.end()) ? -1 : found->second;
 }
 
 
 long get_id_by_name(const char *name)
 {
-  unsigned int i;
+  long pos = get_ptable_by_name(name);
 
-  for (i = 0; i < player_table.size(); i++)
-    if (!str_cmp(player_table[i].name.c_str(), name))
-      return (player_table[i].id);
-
-  return -1;
+  return (pos < 0) ? -1 : player_table[pos].id;
 }
 
 
 std::string get_name_by_id(long id)
 {
-  unsigned int i;
-
-  for (i = 0; i < player_table.size(); i++)
-    if (player_table[i].id == id)
-      return (player_table[i].name);
+  auto found = player_id_index.find(id);
 
-  return std::string();
+  return (found == player_id_index.end()) ? std::string() : player_table[found->second].name;
 }
 
 
@@ -1375,6 +1677,7 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
   std::for_each(st->affected, st->affected+MAX_AFFECT, [](affected_type &a) { a = affected_type(); });
   for (auto af = ch->affected.begin(); af != ch->affected.end() && (i < MAX_AFFECT); ++af, i++) {
     st->affected[i] = *af;
+    st->affected[i].duration = affect_duration(*af);
   }
 
   /*
@@ -1426,8 +1729,7 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
       basic_mud_log("SYSERR: char_to_store: %s's description length: %lu, max: %lu! "
 		    "Truncated.", GET_PC_NAME(ch), ch->player.description.length(),
 		    sizeof(st->description));
-      ch->player.description = ch->player.description.substr(0,sizeof(st->description)-3);      
-      ch->player.description += "\r\n";	/* strcat: OK (previous line makes room) */
+      ch->player.description = ch->player.description.str().substr(0,sizeof(st->description)-3) + "\r\n";
     }
     strcpy(st->description, ch->player.description.c_str());	/* strcpy: OK (checked above) */
   } else
@@ -1457,16 +1759,15 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
  */
 int create_entry(const char *name)
 {
-  int i;
+  int pos = player_table.size();
 
   player_table.push_back(player_index_element());
-  player_table.back().name = new char[strlen(name) + 1];
 
   /* copy lowercase equivalent of name to table field */
-  for (i = 0; (player_table.back().name[i] = LOWER(name[i])); i++)
-    ;
+  player_table[pos].name = player_key(name);
+  player_name_index.emplace(player_table[pos].name, pos);
 
-  return (player_table.size() - 1);
+  return (pos);
 }
 
 
@@ -1533,12 +1834,15 @@ void free_char(struct char_data *ch)
     }
   }
 
-  std::for_each(ch->affected.begin(), ch->affected.end(), [&ch](affected_type &a) { affect_remove(ch, a); });
+  /* affect_remove() takes the node away, so always remove the first one. */
+  while (!ch->affected.empty())
+    affect_remove(ch, ch->affected.front());
 
   if (ch->desc)
     ch->desc->character = nullptr;
 
-  free(ch);
+  cancel_timer(ch->tick);
+  delete ch;
 }
 
 /* release memory allocated for an obj struct */
@@ -1758,9 +2062,10 @@ void init_char(struct char_data *ch)
     GET_HEIGHT(ch) = rand_number(150, 180); /* 5'0" - 6'0" */
   }
 
-  if ((i = get_ptable_by_name(GET_NAME(ch))) != -1)
+  if ((i = get_ptable_by_name(GET_NAME(ch))) != -1) {
     player_table[i].id = GET_IDNUM(ch) = ++top_idnum;
-  else
+    index_player_id(i);
+  } else
     basic_mud_log("SYSERR: init_char: Character '%s' not found in player table.", GET_NAME(ch));
 
   for (i = 1; i <= MAX_SKILLS; i++) {
@@ -1794,35 +2099,28 @@ void init_char(struct char_data *ch)
 /* returns the real number of the room with given virtual number */
 room_rnum real_room(room_vnum vnum)
 {
-  auto it = std::find_if(world.begin(), world.end(), [&vnum](const room_data &r) { return (r.number == vnum); });
-  return (it == world.end()) ? NOWHERE : std::distance(world.begin(), it);
+  return room_vnums.find(vnum);
 }
 
 
 /* returns the real number of the monster with given virtual number */
 mob_rnum real_mobile(mob_vnum vnum)
 {
-  auto found = std::find_if(mob_index.begin(), mob_index.end(), [=](index_data idx) { return idx.vnum == vnum; });
-  if (found == mob_index.end()) {
-    return NOBODY;
-  }
-  return std::distance(mob_index.begin(), found);
+  return mob_vnums.find(vnum);
 }
 
 
 /* returns the real number of the object with given virtual number */
 obj_rnum real_object(obj_vnum vnum)
 {
-  auto it = std::find_if(obj_proto.begin(), obj_proto.end(), [&vnum](const obj_data &o) { return (o.vnum == vnum); });
-  return (it == obj_proto.end()) ? NOTHING : std::distance(obj_proto.begin(), it);
+  return obj_vnums.find(vnum);
 }
 
 
 /* returns the real number of the zone with given virtual number */
 room_rnum real_zone(room_vnum vnum)
 {
-  auto it = std::find_if(zone_table.begin(), zone_table.end(), [&vnum](const zone_data &z) { return z.number == vnum; });
-  return (it == zone_table.end()) ? NOWHERE : std::distance(zone_table.begin(), it);
+  return zone_vnums.find(vnum);
 }
 
 /*
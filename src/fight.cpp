@@ -25,11 +25,15 @@
 #include "fight.h"
 #include "config.h"
 #include "act.h"
+#include "simulate.h"
 
 #include <algorithm>
+#include <map>
 
 /* Structures */
-struct std::list<char_data *> combat_list;
+char_list combat_list;
+/* perform_violence()'s next fighter; stop_fighting() steps it past erasures */
+static char_list::iterator next_combat = combat_list.end();
 
 /* local functions */
 void perform_group_gain(struct char_data *ch, int base, struct char_data *victim);
@@ -149,6 +153,15 @@ void load_messages(void)
   }
 
   fclose(fl);
+
+  /* They are here to stay now; compile them for act() once. */
+  for (const message_list &list : fight_messages)
+    for (const message_type &m : list.msg)
+      for (const msg_type *t : { &m.die_msg, &m.miss_msg, &m.hit_msg, &m.god_msg }) {
+	precompile_act(t->attacker_msg.c_str());
+	precompile_act(t->victim_msg.c_str());
+	precompile_act(t->room_msg.c_str());
+      }
 }
 
 
@@ -213,8 +226,13 @@ void set_fighting(struct char_data *ch, struct char_data *vict)
 /* remove a char from the list of fighting chars */
 void stop_fighting(struct char_data *ch)
 {
-  auto removed = std::remove(combat_list.begin(), combat_list.end(), ch);
-  combat_list.erase(removed, combat_list.end());
+  auto pos = std::find(combat_list.begin(), combat_list.end(), ch);
+
+  if (pos != combat_list.end()) {
+    if (pos == next_combat)
+      ++next_combat;
+    combat_list.erase(pos);
+  }
 
   FIGHTING(ch) = NULL;
   GET_POS(ch) = POS_STANDING;
@@ -285,6 +303,7 @@ void make_corpse(struct char_data *ch)
   IS_CARRYING_W(ch) = 0;
 
   obj_to_room(corpse, IN_ROOM(ch));
+  start_corpse_decay(corpse);
 }
 
 
@@ -318,7 +337,8 @@ void raw_kill(struct char_data *ch)
   if (FIGHTING(ch))
     stop_fighting(ch);
 
-  std::for_each(ch->affected.begin(), ch->affected.end(), [&ch](affected_type &a) { affect_remove(ch, a); });
+  while (!ch->affected.empty())
+    affect_remove(ch, ch->affected.front());
 
   death_cry(ch);
 
@@ -454,11 +474,30 @@ char *replace_string(const char *str, const char *weapon_singular, const char *w
 }
 
 
+/*
+ * A dam_message() line with the weapon filled in.  Each is made once and
+ * kept, so act() has it compiled and finds it by address from then on.
+ */
+static const char *weapon_message(const char *str, int w_type)
+{
+  static std::map<std::pair<const char *, int>, std::string> filled;
+  auto key = std::make_pair(str, w_type);
+  auto it = filled.find(key);
+
+  if (it == filled.end()) {
+    it = filled.emplace(key, replace_string(str, attack_hit_text[w_type].singular,
+		attack_hit_text[w_type].plural)).first;
+    precompile_act(it->second.c_str());
+  }
+
+  return (it->second.c_str());
+}
+
+
 /* message for doing damage with a weapon */
 void dam_message(int dam, struct char_data *ch, struct char_data *victim,
 		      int w_type)
 {
-  char *buf;
   int msgnum;
 
   static struct dam_weapon_type {
@@ -538,22 +577,16 @@ void dam_message(int dam, struct char_data *ch, struct char_data *victim,
   else			msgnum = 8;
 
   /* damage message to onlookers */
-  buf = replace_string(dam_weapons[msgnum].to_room,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, CommTarget::TO_NOTVICT);
+  act(weapon_message(dam_weapons[msgnum].to_room, w_type), FALSE, ch, NULL, victim, CommTarget::TO_NOTVICT);
 
   /* damage message to damager */
   send_to_char(ch, CCYEL(ch, C_CMP));
-  buf = replace_string(dam_weapons[msgnum].to_char,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, CommTarget::TO_CHAR);
+  act(weapon_message(dam_weapons[msgnum].to_char, w_type), FALSE, ch, NULL, victim, CommTarget::TO_CHAR);
   send_to_char(ch, CCNRM(ch, C_CMP));
 
   /* damage message to damagee */
   send_to_char(victim, CCRED(victim, C_CMP));
-  buf = replace_string(dam_weapons[msgnum].to_victim,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, CommTarget::TO_VICT | CommTarget::TO_SLEEP);
+  act(weapon_message(dam_weapons[msgnum].to_victim, w_type), FALSE, ch, NULL, victim, CommTarget::TO_VICT | CommTarget::TO_SLEEP);
   send_to_char(victim, CCNRM(victim, C_CMP));
 }
 
@@ -571,11 +604,11 @@ int skill_message(int dam, struct char_data *ch, struct char_data *vict,
 
 
   for (auto it = fight_messages.begin(); it != fight_messages.end(); ++it) {
-    message_list current = *it;
+    const message_list &current = *it;
 
     if (current.a_type == attacktype) {
       nr = dice(1, current.msg.size() - 1);
-      message_type msg = current.msg[nr];
+      const message_type &msg = current.msg[nr];
 
       if (!IS_NPC(vict) && (GET_LEVEL(vict) >= LVL_IMMORT)) {
       	act(msg.god_msg.attacker_msg.c_str(), FALSE, ch, weap, vict, CommTarget::TO_CHAR);
@@ -922,10 +955,12 @@ void hit(struct char_data *ch, struct char_data *victim, int type)
 /* control the fights going on.  Called every 2 seconds from comm.c. */
 void perform_violence(void)
 {
+  sim_stopwatch timing(SIM_PERFORM_VIOLENCE);
   struct char_data *ch;
 
-  for (auto it = combat_list.begin(); it != combat_list.end();  ++it) {
+  for (auto it = combat_list.begin(); it != combat_list.end(); it = next_combat) {
     ch = *it;
+    next_combat = std::next(it);
 
     if (FIGHTING(ch) == NULL || IN_ROOM(ch) != IN_ROOM(FIGHTING(ch))) {
       stop_fighting(ch);
@@ -956,4 +991,5 @@ void perform_violence(void)
       (GET_MOB_SPEC(ch)) (ch, ch, 0, actbuf);
     }
   }
+  next_combat = combat_list.end();
 }
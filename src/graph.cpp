@@ -11,6 +11,7 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#include <unordered_map>
 
 #include "structs.h"
 #include "utils.h"
@@ -21,37 +22,44 @@
 #include "spells.h"
 #include "act.h"
 #include "constants.h"
+#include "config.h"
+#include "graph.h"
 
 /* external functions */
 ACMD(do_say);
 
 /* local functions */
 int VALID_EDGE(room_rnum x, int y);
-void bfs_enqueue(room_rnum room, int dir);
-void bfs_dequeue(void);
-void bfs_clear_queue(void);
-int find_first_step(room_rnum src, room_rnum target);
 ACMD(do_track);
-void hunt_victim(struct char_data *ch);
 
 struct bfs_queue_struct {
   room_rnum room;
-  char dir;
-  struct bfs_queue_struct *next;
+  char dir;		/* first step from the source */
+  char via;		/* step taken into this room */
+  int from;		/* queue slot of the room before, -1 for the source */
 };
 
-static struct bfs_queue_struct *queue_head = 0, *queue_tail = 0;
+/*
+ * State kept from one search to the next.  A room has been seen by the
+ * current search when its stamp equals the generation, so starting a new
+ * search is one increment instead of a pass over the world.  No room is
+ * queued twice, so a queue as big as the world never overflows.
+ */
+static struct {
+  std::vector<unsigned int> seen;
+  std::vector<struct bfs_queue_struct> queue;
+  unsigned int generation;
+} bfs;
 
 /* Utility macros */
-#define MARK(room)	(SET_BIT(ROOM_FLAGS(room), ROOM_BFS_MARK))
-#define UNMARK(room)	(REMOVE_BIT(ROOM_FLAGS(room), ROOM_BFS_MARK))
-#define IS_MARKED(room)	(ROOM_FLAGGED(room, ROOM_BFS_MARK))
+#define MARK(room)	(bfs.seen[(room)] = bfs.generation)
+#define IS_MARKED(room)	(bfs.seen[(room)] == bfs.generation)
 #define TOROOM(x, y)	(std::get<0>(world[(x)].dir_option[(y)]).to_room)
 #define IS_CLOSED(x, y)	(EXIT_FLAGGED(std::get<0>(world[(x)].dir_option[(y)]), EX_CLOSED))
 
 int VALID_EDGE(room_rnum x, int y)
 {
-  if (std::get<1>(world[x].dir_option[y]) || TOROOM(x, y) == NOWHERE)
+  if (!std::get<1>(world[x].dir_option[y]) || TOROOM(x, y) == NOWHERE)
     return 0;
   if (track_through_doors == FALSE && IS_CLOSED(x, y))
     return 0;
@@ -61,39 +69,90 @@ int VALID_EDGE(room_rnum x, int y)
   return 1;
 }
 
-void bfs_enqueue(room_rnum room, int dir)
+
+/*
+ * Remembered routes, keyed by source and target room.  A route is only
+ * good for the epoch it was found in; routes_changed() starts a new one,
+ * which forgets every route at once without touching the table.
+ */
+struct route_data {
+  int dir;
+  unsigned long epoch;
+};
+
+static std::unordered_map<unsigned long, struct route_data> routes;
+static unsigned long route_epoch;
+static size_t route_world_size;
+
+#define ROUTE_KEY(src, target)	(((unsigned long) (ush_int) (src) << 16) | (ush_int) (target))
+
+
+void routes_changed(void)
+{
+  route_epoch++;
+}
+
+
+/* A closed door only stands in the way if track can't go through it. */
+void door_changed(void)
 {
-  struct bfs_queue_struct *curr;
-
-  curr = new bfs_queue_struct;
-  curr->room = room;
-  curr->dir = dir;
-  curr->next = 0;
-
-  if (queue_tail) {
-    queue_tail->next = curr;
-    queue_tail = curr;
-  } else
-    queue_head = queue_tail = curr;
+  if (track_through_doors == FALSE)
+    routes_changed();
 }
 
 
-void bfs_dequeue(void)
+static int known_route(room_rnum src, room_rnum target)
 {
-  struct bfs_queue_struct *curr;
+  if (route_world_size != world.size()) {
+    route_world_size = world.size();
+    routes_changed();
+  }
 
-  curr = queue_head;
+  auto it = routes.find(ROUTE_KEY(src, target));
 
-  if (!(queue_head = queue_head->next))
-    queue_tail = 0;
-  free(curr);
+  if (it == routes.end() || it->second.epoch != route_epoch)
+    return (BFS_ERROR);
+  return (it->second.dir);
 }
 
 
-void bfs_clear_queue(void)
+static void remember_route(room_rnum src, room_rnum target, int dir)
 {
-  while (queue_head)
-    bfs_dequeue();
+  if (routes.size() >= static_cast<size_t>(route_cache_size))
+    routes.clear();
+
+  struct route_data &r = routes[ROUTE_KEY(src, target)];
+
+  r.dir = dir;
+  r.epoch = route_epoch;
+}
+
+
+/*
+ * Every room on a shortest path is on a shortest path from itself too, so
+ * once the target is found, remember the way on from each room along it.
+ */
+static void remember_path(room_rnum src, room_rnum target, int found)
+{
+  for (int i = found; i >= 0; i = bfs.queue[i].from)
+    remember_route(bfs.queue[i].from < 0 ? src : bfs.queue[bfs.queue[i].from].room,
+		   target, bfs.queue[i].via);
+}
+
+
+/* Start a search with nothing seen, growing the tables if the world has. */
+static void bfs_begin(void)
+{
+  if (bfs.seen.size() != world.size()) {
+    bfs.seen.assign(world.size(), 0);
+    bfs.queue.resize(world.size());
+    bfs.generation = 0;
+  }
+
+  if (++bfs.generation == 0) {	/* wrapped: old stamps could match again */
+    std::fill(bfs.seen.begin(), bfs.seen.end(), 0);
+    bfs.generation = 1;
+  }
 }
 
 
@@ -106,8 +165,7 @@ void bfs_clear_queue(void)
  */
 int find_first_step(room_rnum src, room_rnum target)
 {
-  int curr_dir;
-  room_rnum curr_room;
+  int curr_dir, head = 0, tail = 0;
 
   if (src == NOWHERE || target == NOWHERE || static_cast<unsigned long>(src) >= world.size() || static_cast<unsigned long>(target) >= world.size()) {
     basic_mud_log("SYSERR: Illegal value %d or %d passed to find_first_step. (%s)", src, target, __FILE__);
@@ -116,35 +174,44 @@ int find_first_step(room_rnum src, room_rnum target)
   if (src == target)
     return (BFS_ALREADY_THERE);
 
-  /* clear marks first, some OLC systems will save the mark. */
-  for (curr_room = 0; static_cast<unsigned long>(curr_room) < world.size(); curr_room++)
-    UNMARK(curr_room);
+  if (route_cache_size > 0 && (curr_dir = known_route(src, target)) != BFS_ERROR)
+    return (curr_dir);
 
+  bfs_begin();
   MARK(src);
 
   /* first, enqueue the first steps, saving which direction we're going. */
   for (curr_dir = 0; curr_dir < NUM_OF_DIRS; curr_dir++)
     if (VALID_EDGE(src, curr_dir)) {
       MARK(TOROOM(src, curr_dir));
-      bfs_enqueue(TOROOM(src, curr_dir), curr_dir);
+      bfs.queue[tail].room = TOROOM(src, curr_dir);
+      bfs.queue[tail].dir = bfs.queue[tail].via = curr_dir;
+      bfs.queue[tail++].from = -1;
     }
 
   /* now, do the classic BFS. */
-  while (queue_head) {
-    if (queue_head->room == target) {
-      curr_dir = queue_head->dir;
-      bfs_clear_queue();
-      return (curr_dir);
-    } else {
-      for (curr_dir = 0; curr_dir < NUM_OF_DIRS; curr_dir++)
-	if (VALID_EDGE(queue_head->room, curr_dir)) {
-	  MARK(TOROOM(queue_head->room, curr_dir));
-	  bfs_enqueue(TOROOM(queue_head->room, curr_dir), queue_head->dir);
-	}
-      bfs_dequeue();
+  while (head < tail) {
+    struct bfs_queue_struct curr = bfs.queue[head];
+
+    if (curr.room == target) {
+      if (route_cache_size > 0)
+	remember_path(src, target, head);
+      return (curr.dir);
     }
+
+    for (curr_dir = 0; curr_dir < NUM_OF_DIRS; curr_dir++)
+      if (VALID_EDGE(curr.room, curr_dir)) {
+	MARK(TOROOM(curr.room, curr_dir));
+	bfs.queue[tail].room = TOROOM(curr.room, curr_dir);
+	bfs.queue[tail].dir = curr.dir;
+	bfs.queue[tail].via = curr_dir;
+	bfs.queue[tail++].from = head;
+      }
+    head++;
   }
 
+  if (route_cache_size > 0)
+    remember_route(src, target, BFS_NO_PATH);
   return (BFS_NO_PATH);
 }
 
@@ -10,6 +10,7 @@
 
 #include <iterator>
 #include <list>
+#include <vector>
 
 #include "conf.h"
 #include "sysdep.h"
@@ -25,9 +26,11 @@
 #include "fight.h"
 #include "config.h"
 #include "act.h"
+#include "timer_wheel.h"
+#include "simulate.h"
 
 /* local vars */
-int extractions_pending = 0;
+std::vector<char_data *> extraction_queue;	/* waiting for extract_pending_chars() */
 
 /* local functions */
 int apply_ac(struct char_data *ch, int eq_pos);
@@ -269,14 +272,73 @@ void affect_total(struct char_data *ch)
 
 
 
+/*
+ * Timed affects wear off on the hourly affect_update(), which counts the
+ * hours in affect_hour.  Each one is filed here under the hour it wears
+ * off in, so the update need only look at those.  Only characters in the
+ * game have theirs filed: a player at the menu or logging in keeps the
+ * hours left in 'duration', as the old sweep of character_list did.
+ */
+affect_schedule affect_timers;
+unsigned long affect_hour = 0;
+
+
+/* How many more hours an affect has, the way its duration would count. */
+int affect_duration(const struct char_affect &af)
+{
+  if (!af.expires)
+    return (af.duration);
+  return (af.expires - affect_hour - 1);
+}
+
+
+/* Mobiles, and players past the menu (linkless or not), are in the game. */
+static bool affects_running(struct char_data *ch)
+{
+  return (!ch->desc || STATE(ch->desc) == CON_PLAYING);
+}
+
+
+static void schedule_affect(struct char_data *ch, struct char_affect &af)
+{
+  af.expires = affect_hour + MAX(0, af.duration) + 1;
+  af.slot = affect_timers.insert(std::make_pair(af.expires, std::make_pair(ch, &af)));
+}
+
+
+/* Leaving the game: take the affects off the clock, with the hours left. */
+void hold_affects(struct char_data *ch)
+{
+  for (auto it = ch->affected.begin(); it != ch->affected.end(); ++it)
+    if (it->expires) {
+      it->duration = affect_duration(*it);
+      affect_timers.erase(it->slot);
+      it->expires = 0;
+    }
+}
+
+
+/* Back in the game: the held affects count down again from where they were. */
+void resume_affects(struct char_data *ch)
+{
+  for (auto it = ch->affected.begin(); it != ch->affected.end(); ++it)
+    if (!it->expires && it->duration != -1)
+      schedule_affect(ch, *it);
+}
+
+
+
 /* Insert an affect_type in a char_data structure
    Automatically sets apropriate bits and apply's */
 void affect_to_char(struct char_data *ch, const affected_type &af)
 {
-  struct affected_type afaf;
+  ch->affected.push_back(af);
 
-  afaf = af;
-  ch->affected.push_back(afaf);
+  struct char_affect &afaf = ch->affected.back();
+
+  /* -1 is for gods only: it never runs out. */
+  if (afaf.duration != -1 && affects_running(ch))
+    schedule_affect(ch, afaf);
 
   affect_modify(ch, afaf.location, afaf.modifier, afaf.bitvector, true);
   affect_total(ch);
@@ -289,15 +351,18 @@ void affect_to_char(struct char_data *ch, const affected_type &af)
  * reaches zero). Pointer *af must never be NIL!  Frees mem and calls
  * affect_location_apply
  */
-void affect_remove(struct char_data *ch, affected_type &af)
+void affect_remove(struct char_data *ch, struct char_affect &af)
 {
   if (ch->affected.empty()) {
     core_dump();
     return;
   }
 
+  if (af.expires)
+    affect_timers.erase(af.slot);
+
   affect_modify(ch, af.location, af.modifier, af.bitvector, false);
-  ch->affected.remove_if([&af](affected_type &a) { return &a == &af; });
+  ch->affected.remove_if([&af](char_affect &a) { return &a == &af; });
   affect_total(ch);
 }
 
@@ -324,6 +389,7 @@ bool affected_by_spell(struct char_data *ch, int type)
   return (ch->affected.end() != std::find_if(ch->affected.begin(), ch->affected.end(), [&type](affected_type &a) { return a.type == type; }));
 }
 
+/* Replace an affect of the same type and location with af, merged into it. */
 void affect_join(struct char_data *ch, affected_type &af, bool add_dur, bool avg_dur, bool add_mod, bool avg_mod)
 {
   auto it = std::find_if(ch->affected.begin(), ch->affected.end(), [&af](const affected_type &a) { 
@@ -332,7 +398,7 @@ void affect_join(struct char_data *ch, affected_type &af, bool add_dur, bool avg
 
   if (it != ch->affected.end()) {
     if (add_dur) 
-      af.duration += it->duration;
+      af.duration += affect_duration(*it);
     if (avg_dur)
       af.duration /= 2;
 
@@ -341,10 +407,9 @@ void affect_join(struct char_data *ch, affected_type &af, bool add_dur, bool avg
     if (avg_mod)
       af.modifier /= 2;
 
-    affect_to_char(ch, af);
-  } else {
-    affect_to_char(ch, af);
+    affect_remove(ch, *it);
   }
+  affect_to_char(ch, af);
 }
 
 
@@ -368,8 +433,9 @@ void char_from_room(struct char_data *ch)
     }
   }
 
-  world[IN_ROOM(ch)].people.remove(ch);
+  world[IN_ROOM(ch)].people.erase(ch->room_pos);
   IN_ROOM(ch) = NOWHERE;
+  update_zone_players(ch);
 }
 
 
@@ -380,8 +446,9 @@ void char_to_room(struct char_data *ch, room_rnum room)
     basic_mud_log("SYSERR: Illegal value(s) passed to char_to_room. (Room: %d/%ld Ch: %p", room, world.size(), reinterpret_cast<void *>(ch));
   }
   else {
-    world[room].people.push_back(ch);
+    ch->room_pos = world[room].people.insert(world[room].people.end(), ch);
     IN_ROOM(ch) = room;
+    update_zone_players(ch);
 
     if (GET_EQ(ch, WEAR_LIGHT)) {
       if (GET_OBJ_TYPE(GET_EQ(ch, WEAR_LIGHT)) == ITEM_LIGHT) {
@@ -401,6 +468,31 @@ void char_to_room(struct char_data *ch, room_rnum room)
 }
 
 
+/*
+ * zone_table[].players counts the mortals who are playing in each zone,
+ * the ones is_empty() looks for.  Call this after anything that could
+ * change whether ch is one of them: its room, its descriptor or that
+ * descriptor's state, or its level.  Calling it when nothing changed is
+ * harmless.
+ */
+void update_zone_players(struct char_data *ch)
+{
+  zone_rnum zone = NOWHERE;
+
+  if (IN_ROOM(ch) != NOWHERE && ch->desc && STATE(ch->desc) == CON_PLAYING && GET_LEVEL(ch) < LVL_IMMORT)
+    zone = world[IN_ROOM(ch)].zone;
+
+  if (zone == ch->counted_in)
+    return;
+
+  if (ch->counted_in != NOWHERE)
+    zone_table[ch->counted_in].players--;
+  if (zone != NOWHERE)
+    zone_table[zone].players++;
+  ch->counted_in = zone;
+}
+
+
 /* give an object to a char   */
 void obj_to_char(struct obj_data *object, struct char_data *ch)
 {
@@ -615,7 +707,7 @@ struct obj_data *get_obj_in_list_num(int num, struct obj_data *list)
   return nullptr;
 }
 
-struct obj_data *get_obj_in_list_num(int num, std::list<obj_data *> &list)
+struct obj_data *get_obj_in_list_num(int num, obj_list &list)
 {
   for (auto it = list.begin(); it != list.end(); ++it) {
     if (GET_OBJ_RNUM(*it) == num) {
@@ -631,13 +723,11 @@ struct obj_data *get_obj_in_list_num(int num, std::list<obj_data *> &list)
 /* search the entire world for an object number, and return a pointer  */
 struct obj_data *get_obj_num(obj_rnum nr)
 {
-  for (auto it = object_list.begin(); it != object_list.end(); ++it) {
-    if (GET_OBJ_RNUM(*it) == nr) {
-      return (*it);
-    }
+  if (nr == NOTHING || static_cast<unsigned long>(nr) >= obj_index.size() || obj_index[nr].objects.empty()) {
+    return nullptr;
   }
 
-  return nullptr;
+  return obj_index[nr].objects.front();
 }
 
 
@@ -675,17 +765,11 @@ struct char_data *get_char_room(char *name, int *number, room_rnum room)
 /* search all over the world for a char num, and return a pointer if found */
 struct char_data *get_char_num(mob_rnum nr)
 {
-  struct char_data *i;
-
-  for (auto it = character_list.begin(); it != character_list.end(); ++ it) {
-    i = *it;
-
-    if (GET_MOB_RNUM(i) == nr) {
-      return i;
-    }
+  if (nr == NOBODY || static_cast<unsigned long>(nr) >= mob_index.size() || mob_index[nr].mobiles.empty()) {
+    return nullptr;
   }
 
-  return nullptr;;
+  return mob_index[nr].mobiles.front();
 }
 
 
@@ -697,7 +781,7 @@ void obj_to_room(struct obj_data *object, room_rnum room)
     basic_mud_log("SYSERR: Illegal value(s) passed to obj_to_room. (Room #%d/%ld, obj %p)", room, world.size(), reinterpret_cast<void *>(object));
   }
   else {
-    world[room].contents.push_back(object);
+    object->room_pos = world[room].contents.insert(world[room].contents.end(), object);
     IN_ROOM(object) = room;
     object->carried_by = nullptr;
     if (ROOM_FLAGGED(room, ROOM_HOUSE))
@@ -714,7 +798,7 @@ void obj_from_room(struct obj_data *object)
     return;
   }
 
-  world[IN_ROOM(object)].contents.remove(object);
+  world[IN_ROOM(object)].contents.erase(object->room_pos);
 
   if (ROOM_FLAGGED(IN_ROOM(object), ROOM_HOUSE)) {
     SET_BIT(ROOM_FLAGS(IN_ROOM(object)), ROOM_HOUSE_CRASH);
@@ -803,9 +887,12 @@ void extract_obj(struct obj_data *obj)
     extract_obj(obj->contains);
 
   object_list.remove(obj);
+  cancel_timer(obj->tick);
 
-  if (GET_OBJ_RNUM(obj) != NOTHING)
+  if (GET_OBJ_RNUM(obj) != NOTHING) {
     (obj_index[GET_OBJ_RNUM(obj)].number)--;
+    obj_index[GET_OBJ_RNUM(obj)].objects.erase(obj->proto_pos);
+  }
   free_obj(obj);
 }
 
@@ -852,7 +939,7 @@ void update_char_objects(struct char_data *ch)
 /* Extract a ch completely from the world, and leave his stuff behind */
 void extract_char_final(struct char_data *ch)
 {
-  struct char_data *k, *temp;
+  struct char_data *k;
   struct descriptor_data *d;
   struct obj_data *obj;
   int i;
@@ -903,6 +990,7 @@ void extract_char_final(struct char_data *ch)
           STATE(d) = CON_CLOSE;
       }
       STATE(ch->desc) = CON_MENU;
+      hold_affects(ch);
       write_to_output(ch->desc, "%s", MENU.c_str());
     }
   }
@@ -927,24 +1015,21 @@ void extract_char_final(struct char_data *ch)
   if (FIGHTING(ch))
     stop_fighting(ch);
 
-  for (auto it = combat_list.begin(); it != combat_list.end(); ++ it) {
-    k = *it;
+  for (auto it = combat_list.begin(); it != combat_list.end(); ) {
+    k = *it++;
     if (FIGHTING(k) == ch) {
       stop_fighting(k);
     }
   }
-  /* we can't forget the hunters either... */
-  for (auto it = character_list.begin(); it != character_list.end(); ++ it) {
-      temp = *it;
-      if (HUNTING(temp) == ch) {
-        HUNTING(temp) = nullptr;
-      }
-  }
+  /* The hunters are let go in extract_pending_chars(), once per batch. */
   char_from_room(ch);
+  cancel_timer(ch->tick);
 
   if (IS_NPC(ch)) {
-    if (GET_MOB_RNUM(ch) != NOTHING)	/* prototyped */
+    if (GET_MOB_RNUM(ch) != NOTHING) {	/* prototyped */
       mob_index[GET_MOB_RNUM(ch)].number--;
+      mob_index[GET_MOB_RNUM(ch)].mobiles.erase(ch->proto_pos);
+    }
      clearMemory(ch);
   } else {
     save_char(ch);
@@ -972,6 +1057,9 @@ void extract_char_final(struct char_data *ch)
  */
 void extract_char(struct char_data *ch)
 {
+  if (MOB_FLAGGED(ch, MOB_NOTDEADYET) || PLR_FLAGGED(ch, PLR_NOTDEADYET))
+    return;	/* Already queued. */
+
   if (IS_NPC(ch)) {
     SET_BIT(MOB_FLAGS(ch), MOB_NOTDEADYET);
   }
@@ -979,7 +1067,7 @@ void extract_char(struct char_data *ch)
     SET_BIT(PLR_FLAGS(ch), PLR_NOTDEADYET);
   }
 
-  extractions_pending++;
+  extraction_queue.push_back(ch);
 }
 
 
@@ -987,46 +1075,43 @@ void extract_char(struct char_data *ch)
  * I'm not particularly pleased with the MOB/PLR
  * hoops that have to be jumped through but it
  * hardly calls for a completely new variable.
- * Ideally it would be its own list, but that
- * would change the '->next' pointer, potentially
- * confusing some code. Ugh. -gg 3/15/2001
+ * The flags now only say "already queued"; the
+ * queue itself is extraction_queue, and each
+ * victim remembers its own node in character_list.
  *
- * NOTE: This doesn't handle recursive extractions.
+ * Extractions queued while draining (recursive
+ * extractions) are picked up by the next round.
  */
 void extract_pending_chars(void)
 {
-  struct char_data *vict;
-
-  if (extractions_pending < 0) {
-    basic_mud_log("SYSERR: Negative (%d) extractions pending.", extractions_pending);
-  }
-
-  int extracted = 0;
-  do {
-    auto found = std::find_if(character_list.begin(), character_list.end(), [](char_data *x){return MOB_FLAGGED(x, MOB_NOTDEADYET) || PLR_FLAGGED(x, PLR_NOTDEADYET); });
+  sim_stopwatch timing(SIM_EXTRACTIONS);
+  std::vector<char_data *> victims;
 
-    if (found == character_list.end()) {
-      break;
-    }
+  while (!extraction_queue.empty()) {
+    victims.swap(extraction_queue);
 
-    vict = *found;
-    extracted++;
-    if (MOB_FLAGGED(vict, MOB_NOTDEADYET)) {
-      REMOVE_BIT(MOB_FLAGS(vict), MOB_NOTDEADYET);
+    /* Anyone hunting one of the victims loses the trail. */
+    for (auto it = character_list.begin(); it != character_list.end(); ++it) {
+      struct char_data *prey = HUNTING(*it);
+      if (prey && (MOB_FLAGGED(prey, MOB_NOTDEADYET) || PLR_FLAGGED(prey, PLR_NOTDEADYET)))
+        HUNTING(*it) = nullptr;
     }
-    else if (PLR_FLAGGED(vict, PLR_NOTDEADYET)) {
-      REMOVE_BIT(PLR_FLAGS(vict), PLR_NOTDEADYET);
-    }    
-    extract_char_final(vict);
-    character_list.remove(vict);
-
-  } while(false);
-  extractions_pending -= extracted;
 
-  if (extractions_pending > 0)
-    basic_mud_log("SYSERR: Couldn't find %d extractions as counted.", extractions_pending);
+    for (auto it = victims.begin(); it != victims.end(); ++it) {
+      struct char_data *vict = *it;
+      auto pos = vict->list_pos;
 
-  extractions_pending = 0;
+      if (MOB_FLAGGED(vict, MOB_NOTDEADYET)) {
+        REMOVE_BIT(MOB_FLAGS(vict), MOB_NOTDEADYET);
+      }
+      else if (PLR_FLAGGED(vict, PLR_NOTDEADYET)) {
+        REMOVE_BIT(PLR_FLAGS(vict), PLR_NOTDEADYET);
+      }
+      extract_char_final(vict);
+      character_list.erase(pos);
+    }
+    victims.clear();
+  }
 }
 
 
@@ -1155,7 +1240,7 @@ struct char_data *get_char_vis(struct char_data *ch, char *name, int *number, in
   return nullptr;
 }
 
-struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, std::list<obj_data *> &list)
+struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, obj_list &list)
 {
   int num;
 
@@ -1366,7 +1451,7 @@ struct obj_data *create_money(int amount)
     new_descr.description = strdup(buf);
   }
   
-  obj->ex_description.push_back(new_descr);
+  obj->ex_description.edit().push_back(new_descr);
 
   GET_OBJ_TYPE(obj) = ITEM_MONEY;
   GET_OBJ_WEAR(obj) = ITEM_WEAR_TAKE;
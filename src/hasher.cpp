@@ -0,0 +1,77 @@
+/*
+ * hasher.cpp
+ *
+ * The worker pool behind hash_password().  game_loop() drains the results
+ * once per pass through check_password_hashes().
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <memory>
+
+#include "structs.h"
+#include "utils.h"
+#include "hasher.h"
+#include "worker_pool.h"
+
+struct password_job {
+  char plain[MAX_INPUT_LENGTH];
+  char salt[MAX_INPUT_LENGTH];
+
+  /* Don't leave plaintext lying around in freed queue nodes. */
+  ~password_job() { memset(plain, 0, sizeof(plain)); }
+};
+
+static std::unique_ptr<worker_pool<password_job, std::string> > hashers;
+
+
+static std::string run_crypt(const password_job &job)
+{
+  const char *hash;
+
+#if defined(NOCRYPT) || !defined(CIRCLE_CRYPT)
+  hash = job.plain;
+#elif defined(HAVE_CRYPT_R)
+  static thread_local struct crypt_data data;
+
+  hash = crypt_r(job.plain, job.salt, &data);
+#else
+  /* Plain crypt() answers in a static buffer, so one at a time. */
+  static std::mutex crypt_lock;
+  std::lock_guard<std::mutex> guard(crypt_lock);
+
+  hash = crypt(job.plain, job.salt);
+#endif
+
+  return std::string(hash ? hash : "");
+}
+
+
+void init_hashers(int threads)
+{
+  hashers.reset(new worker_pool<password_job, std::string>(run_crypt, threads));
+}
+
+
+void shutdown_hashers(void)
+{
+  hashers.reset();
+}
+
+
+unsigned long hash_password(const char *plain, const char *salt)
+{
+  password_job job;
+
+  strlcpy(job.plain, plain, sizeof(job.plain));
+  strlcpy(job.salt, salt, sizeof(job.salt));
+
+  return hashers->submit(job);
+}
+
+
+bool collect_password_hash(unsigned long *ticket, std::string &hash)
+{
+  return hashers && hashers->collect(*ticket, hash);
+}
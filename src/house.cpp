@@ -32,8 +32,8 @@ int num_of_houses = 0;
 /* local functions */
 int House_get_filename(room_vnum vnum, char *filename, size_t maxlen);
 int House_load(room_vnum vnum);
-int House_save(std::list<obj_data *> &obj, FILE *fp);
-void House_restore_weight(std::list<obj_data *> &objs);
+int House_save(obj_list &obj, FILE *fp);
+void House_restore_weight(obj_list &objs);
 void House_delete_file(room_vnum vnum);
 int find_house(room_vnum vnum);
 void House_save_control(void);
@@ -91,7 +91,7 @@ int House_load(room_vnum vnum)
 
 /* Save all objects for a house (recursive; initial call must be followed
    by a call to House_restore_weight)  Assumes file is open already. */
-int House_save(std::list<obj_data *> &objs, FILE *fp)
+int House_save(obj_list &objs, FILE *fp)
 {
   struct obj_data *tmp;
   int result;
@@ -111,7 +111,7 @@ int House_save(std::list<obj_data *> &objs, FILE *fp)
 
 
 /* restore weight of containers after House_save has changed them for saving */
-void House_restore_weight(std::list<obj_data *> &objs)
+void House_restore_weight(obj_list &objs)
 {
   for(auto it = objs.begin(); it != objs.end(); ++it) {
     if ((*it)->in_obj) {
@@ -190,7 +190,7 @@ void House_listrent(struct char_data *ch, room_vnum vnum)
     }
     if (!feof(fl) && (obj = Obj_from_store(object, &i)) != NULL) {
       send_to_char(ch, " [%5d] (%5dau) %s\r\n", GET_OBJ_VNUM(obj), GET_OBJ_RENT(obj), obj->short_description.c_str());
-      free_obj(obj);
+      extract_obj(obj);
     }
   }
   fclose(fl);
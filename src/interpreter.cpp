@@ -13,6 +13,9 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#include <utility>
+#include <vector>
+
 #include "structs.h"
 #include "comm.h"
 #include "interpreter.h"
@@ -26,6 +29,7 @@
 #include "config.h"
 #include "act.h"
 #include "ban.h"
+#include "hasher.h"
 
 /* external variables */
 extern room_rnum r_mortal_start_room;
@@ -555,6 +559,75 @@ const char *reserved[] =
   "\n"
 };
 
+/*
+ * Prefix trie over cmd_info[], built at boot by build_command_trie().  Each
+ * node stands for the prefix spelled by the path to it.  'first' holds, in
+ * cmd_info[] order, each command under that prefix whose minimum level is
+ * lower than that of every command listed before it.  The first entry the
+ * player has the level for is therefore the same command the old strncmp()
+ * walk over cmd_info[] picked, and a lookup costs one step per character.
+ */
+struct command_node {
+  std::vector<std::pair<char, int> > next;	/* children, by character */
+  std::vector<int> first;			/* see above */
+};
+
+static std::vector<command_node> command_trie;
+
+
+static int command_child(int node, char c)
+{
+  for (auto it = command_trie[node].next.begin(); it != command_trie[node].next.end(); ++it)
+    if (it->first == c)
+      return (it->second);
+
+  return (-1);
+}
+
+
+void build_command_trie(void)
+{
+  int cmd, node, child;
+  const char *c;
+
+  command_trie.assign(1, command_node());
+
+  for (cmd = 0; *cmd_info[cmd].command != '\n'; cmd++) {
+    for (node = 0, c = cmd_info[cmd].command; ; c++) {
+      std::vector<int> &first = command_trie[node].first;
+      if (first.empty() || cmd_info[cmd].minimum_level < cmd_info[first.back()].minimum_level)
+        first.push_back(cmd);
+
+      if (!*c)
+        break;
+      if ((child = command_child(node, *c)) < 0) {
+        child = command_trie.size();
+        command_trie.push_back(command_node());
+        command_trie[node].next.push_back(std::make_pair(*c, child));
+      }
+      node = child;
+    }
+  }
+}
+
+
+/* First command in cmd_info[] that 'arg' abbreviates and 'level' may use. */
+static int lookup_command(const char *arg, int level)
+{
+  int node = 0;
+
+  for (; *arg; arg++)
+    if ((node = command_child(node, *arg)) < 0)
+      return (-1);
+
+  for (auto it = command_trie[node].first.begin(); it != command_trie[node].first.end(); ++it)
+    if (level >= cmd_info[*it].minimum_level)
+      return (*it);
+
+  return (-1);
+}
+
+
 /*
  * This is the actual command interpreter called from game_loop() in comm.c
  * It makes sure you are the proper level and position to execute the command,
@@ -562,7 +635,7 @@ const char *reserved[] =
  */
 void command_interpreter(struct char_data *ch, char *argument)
 {
-  int cmd, length;
+  int cmd;
   char *line;
   char arg[MAX_INPUT_LENGTH];
 
@@ -586,12 +659,7 @@ void command_interpreter(struct char_data *ch, char *argument)
     line = any_one_arg(argument, arg);
 
   /* otherwise, find the command */
-  for (length = strlen(arg), cmd = 0; *cmd_info[cmd].command != '\n'; cmd++)
-    if (!strncmp(cmd_info[cmd].command, arg, length))
-      if (GET_LEVEL(ch) >= cmd_info[cmd].minimum_level)
-	break;
-
-  if (*cmd_info[cmd].command == '\n')
+  if ((cmd = lookup_command(arg, GET_LEVEL(ch))) < 0)
     send_to_char(ch, "Huh?!?\r\n");
   else if (!IS_NPC(ch) && PLR_FLAGGED(ch, PLR_FROZEN) && GET_LEVEL(ch) < LVL_IMPL)
     send_to_char(ch, "You try, but the mind-numbing cold prevents you...\r\n");
@@ -1175,8 +1243,10 @@ int perform_dupe_check(struct descriptor_data *d)
 	target = k->original;
 	mode = UNSWITCH;
       }
-      if (k->character)
+      if (k->character) {
 	k->character->desc = NULL;
+	update_zone_players(k->character);
+      }
       k->character = NULL;
       k->original = NULL;
     } else if (k->character && GET_IDNUM(k->character) == id && k->original) {
@@ -1192,6 +1262,7 @@ int perform_dupe_check(struct descriptor_data *d)
 	mode = USURP;
       }
       k->character->desc = NULL;
+      update_zone_players(k->character);
       k->character = NULL;
       k->original = NULL;
       write_to_output(k, "\r\nMultiple login detected -- disconnecting.\r\n");
@@ -1256,6 +1327,7 @@ int perform_dupe_check(struct descriptor_data *d)
   REMOVE_BIT(PLR_FLAGS(d->character), PLR_MAILING | PLR_WRITING);
   REMOVE_BIT(AFF_FLAGS(d->character), AFF_GROUP);
   STATE(d) = CON_PLAYING;
+  update_zone_players(d->character);
 
   switch (mode) {
   case RECON:
@@ -1282,6 +1354,178 @@ int perform_dupe_check(struct descriptor_data *d)
 
 
 
+/*
+ * crypt() is slow on purpose, so nanny() doesn't call it: verify_password()
+ * hands the input to the hasher threads and parks the descriptor in
+ * CON_VERIFYING, and password_hashed() carries on from the state it was
+ * in once check_password_hashes() has the answer.
+ */
+static void verify_password(struct descriptor_data *d, const char *arg, const char *salt)
+{
+  d->crypt_state = STATE(d);
+  d->crypt_job = hash_password(arg, salt);
+  STATE(d) = CON_VERIFYING;
+}
+
+
+static void password_hashed(struct descriptor_data *d, const char *hash)
+{
+  int load_result;
+  bool match = *hash && !strncmp(hash, GET_PASSWD(d->character), MAX_PWD_LENGTH);
+
+  switch ((STATE(d) = d->crypt_state)) {
+  case CON_PASSWORD:
+    if (!match) {
+      mudlog(BRF, LVL_GOD, TRUE, "Bad PW: %s [%s]", GET_NAME(d->character), d->host);
+      GET_BAD_PWS(d->character)++;
+      save_char(d->character);
+      if (++(d->bad_pws) >= max_bad_pws) {	/* 3 strikes and you're out. */
+	write_to_output(d, "Wrong password... disconnecting.\r\n");
+	STATE(d) = CON_CLOSE;
+      } else {
+	write_to_output(d, "Wrong password.\r\nPassword: ");
+	echo_off(d);
+      }
+      return;
+    }
+
+    /* Password was correct. */
+    load_result = GET_BAD_PWS(d->character);
+    GET_BAD_PWS(d->character) = 0;
+    d->bad_pws = 0;
+
+    if (isbanned(d->host) == BAN_SELECT &&
+	!PLR_FLAGGED(d->character, PLR_SITEOK)) {
+      write_to_output(d, "Sorry, this char has not been cleared for login from your site!\r\n");
+      STATE(d) = CON_CLOSE;
+      mudlog(NRM, LVL_GOD, TRUE, "Connection attempt for %s denied from %s", GET_NAME(d->character), d->host);
+      return;
+    }
+    if (GET_LEVEL(d->character) < circle_restrict) {
+      write_to_output(d, "The game is temporarily restricted.. try again later.\r\n");
+      STATE(d) = CON_CLOSE;
+      mudlog(NRM, LVL_GOD, TRUE, "Request for login denied for %s [%s] (wizlock)", GET_NAME(d->character), d->host);
+      return;
+    }
+    /* check and make sure no other copies of this player are logged in */
+    if (perform_dupe_check(d))
+      return;
+
+    if (GET_LEVEL(d->character) >= LVL_IMMORT)
+      write_to_output(d, "%s", imotd.c_str());
+    else
+      write_to_output(d, "%s", motd.c_str());
+
+    mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(d->character)), TRUE, "%s [%s] has connected.", GET_NAME(d->character), d->host);
+
+    if (load_result) {
+      write_to_output(d, "\r\n\r\n\007\007\007"
+		"%s%d LOGIN FAILURE%s SINCE LAST SUCCESSFUL LOGIN.%s\r\n",
+		CCRED(d->character, C_SPR), load_result,
+		(load_result > 1) ? "S" : "", CCNRM(d->character, C_SPR));
+      GET_BAD_PWS(d->character) = 0;
+    }
+    write_to_output(d, "\r\n*** PRESS RETURN: ");
+    STATE(d) = CON_RMOTD;
+    break;
+
+  case CON_NEWPASSWD:
+  case CON_CHPWD_GETNEW:
+    if (!*hash) {
+      write_to_output(d, "\r\nIllegal password.\r\nPassword: ");
+      return;
+    }
+    strncpy(GET_PASSWD(d->character), hash, MAX_PWD_LENGTH);	/* strncpy: OK (G_P:MAX_PWD_LENGTH+1) */
+    *(GET_PASSWD(d->character) + MAX_PWD_LENGTH) = '\0';
+
+    write_to_output(d, "\r\nPlease retype password: ");
+    if (STATE(d) == CON_NEWPASSWD)
+      STATE(d) = CON_CNFPASSWD;
+    else
+      STATE(d) = CON_CHPWD_VRFY;
+    break;
+
+  case CON_CNFPASSWD:
+  case CON_CHPWD_VRFY:
+    if (!match) {
+      write_to_output(d, "\r\nPasswords don't match... start over.\r\nPassword: ");
+      if (STATE(d) == CON_CNFPASSWD)
+	STATE(d) = CON_NEWPASSWD;
+      else
+	STATE(d) = CON_CHPWD_GETNEW;
+      return;
+    }
+    echo_on(d);
+
+    if (STATE(d) == CON_CNFPASSWD) {
+      write_to_output(d, "\r\nWhat is your sex (M/F)? ");
+      STATE(d) = CON_QSEX;
+    } else {
+      save_char(d->character);
+      write_to_output(d, "\r\nDone.\r\n%s", MENU.c_str());
+      STATE(d) = CON_MENU;
+    }
+    break;
+
+  case CON_CHPWD_GETOLD:
+    if (!match) {
+      echo_on(d);
+      write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU.c_str());
+      STATE(d) = CON_MENU;
+    } else {
+      write_to_output(d, "\r\nEnter a new password: ");
+      STATE(d) = CON_CHPWD_GETNEW;
+    }
+    break;
+
+  case CON_DELCNF1:
+    if (!match) {
+      write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU.c_str());
+      STATE(d) = CON_MENU;
+    } else {
+      write_to_output(d, "\r\nYOU ARE ABOUT TO DELETE THIS CHARACTER PERMANENTLY.\r\n"
+		"ARE YOU ABSOLUTELY SURE?\r\n\r\n"
+		"Please type \"yes\" to confirm: ");
+      STATE(d) = CON_DELCNF2;
+    }
+    break;
+
+  default:
+    basic_mud_log("SYSERR: password_hashed: hash for state %d of '%s'; closing connection.",
+	STATE(d), GET_NAME(d->character));
+    STATE(d) = CON_DISCONNECT;
+    break;
+  }
+}
+
+
+/* Resume everyone whose password the hasher threads have finished with. */
+void check_password_hashes(void)
+{
+  struct descriptor_data *d;
+  unsigned long ticket;
+  std::string hash;
+
+  while (collect_password_hash(&ticket, hash)) {
+    for (d = descriptor_list; d; d = d->next)
+      if (d->crypt_job == ticket)
+	break;
+
+    if (!d)		/* Hung up while we were hashing. */
+      continue;
+
+    d->crypt_job = 0;
+    /* Dupe checks and the like may have closed them in the meantime. */
+    if (STATE(d) != CON_VERIFYING || !d->character)
+      continue;
+
+    d->has_prompt = FALSE;
+    password_hashed(d, hash.c_str());
+  }
+}
+
+
+
 /* deal with newcomers and other non-playing sockets */
 void nanny(struct descriptor_data *d, char *arg)
 {
@@ -1400,60 +1644,8 @@ void nanny(struct descriptor_data *d, char *arg)
 
     if (!*arg)
       STATE(d) = CON_CLOSE;
-    else {
-      if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
-	mudlog(BRF, LVL_GOD, TRUE, "Bad PW: %s [%s]", GET_NAME(d->character), d->host);
-	GET_BAD_PWS(d->character)++;
-	save_char(d->character);
-	if (++(d->bad_pws) >= max_bad_pws) {	/* 3 strikes and you're out. */
-	  write_to_output(d, "Wrong password... disconnecting.\r\n");
-	  STATE(d) = CON_CLOSE;
-	} else {
-	  write_to_output(d, "Wrong password.\r\nPassword: ");
-	  echo_off(d);
-	}
-	return;
-      }
-
-      /* Password was correct. */
-      load_result = GET_BAD_PWS(d->character);
-      GET_BAD_PWS(d->character) = 0;
-      d->bad_pws = 0;
-
-      if (isbanned(d->host) == BAN_SELECT &&
-	  !PLR_FLAGGED(d->character, PLR_SITEOK)) {
-	write_to_output(d, "Sorry, this char has not been cleared for login from your site!\r\n");
-	STATE(d) = CON_CLOSE;
-	mudlog(NRM, LVL_GOD, TRUE, "Connection attempt for %s denied from %s", GET_NAME(d->character), d->host);
-	return;
-      }
-      if (GET_LEVEL(d->character) < circle_restrict) {
-	write_to_output(d, "The game is temporarily restricted.. try again later.\r\n");
-	STATE(d) = CON_CLOSE;
-	mudlog(NRM, LVL_GOD, TRUE, "Request for login denied for %s [%s] (wizlock)", GET_NAME(d->character), d->host);
-	return;
-      }
-      /* check and make sure no other copies of this player are logged in */
-      if (perform_dupe_check(d))
-	return;
-
-      if (GET_LEVEL(d->character) >= LVL_IMMORT)
-      	write_to_output(d, "%s", imotd.c_str());
-      else
-      	write_to_output(d, "%s", motd.c_str());
-
-      mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(d->character)), TRUE, "%s [%s] has connected.", GET_NAME(d->character), d->host);
-
-      if (load_result) {
-        write_to_output(d, "\r\n\r\n\007\007\007"
-		"%s%d LOGIN FAILURE%s SINCE LAST SUCCESSFUL LOGIN.%s\r\n",
-		CCRED(d->character, C_SPR), load_result,
-		(load_result > 1) ? "S" : "", CCNRM(d->character, C_SPR));
-	GET_BAD_PWS(d->character) = 0;
-      }
-      write_to_output(d, "\r\n*** PRESS RETURN: ");
-      STATE(d) = CON_RMOTD;
-    }
+    else
+      verify_password(d, arg, GET_PASSWD(d->character));
     break;
 
   case CON_NEWPASSWD:
@@ -1463,37 +1655,12 @@ void nanny(struct descriptor_data *d, char *arg)
       write_to_output(d, "\r\nIllegal password.\r\nPassword: ");
       return;
     }
-    strncpy(GET_PASSWD(d->character), CRYPT(arg, GET_PC_NAME(d->character)), MAX_PWD_LENGTH);	/* strncpy: OK (G_P:MAX_PWD_LENGTH+1) */
-    *(GET_PASSWD(d->character) + MAX_PWD_LENGTH) = '\0';
-
-    write_to_output(d, "\r\nPlease retype password: ");
-    if (STATE(d) == CON_NEWPASSWD)
-      STATE(d) = CON_CNFPASSWD;
-    else
-      STATE(d) = CON_CHPWD_VRFY;
+    verify_password(d, arg, GET_PC_NAME(d->character));
     break;
 
   case CON_CNFPASSWD:
   case CON_CHPWD_VRFY:
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character),
-		MAX_PWD_LENGTH)) {
-      write_to_output(d, "\r\nPasswords don't match... start over.\r\nPassword: ");
-      if (STATE(d) == CON_CNFPASSWD)
-	STATE(d) = CON_NEWPASSWD;
-      else
-	STATE(d) = CON_CHPWD_GETNEW;
-      return;
-    }
-    echo_on(d);
-
-    if (STATE(d) == CON_CNFPASSWD) {
-      write_to_output(d, "\r\nWhat is your sex (M/F)? ");
-      STATE(d) = CON_QSEX;
-    } else {
-      save_char(d->character);
-      write_to_output(d, "\r\nDone.\r\n%s", MENU.c_str());
-      STATE(d) = CON_MENU;
-    }
+    verify_password(d, arg, GET_PASSWD(d->character));
     break;
 
   case CON_QSEX:		/* query sex of new user         */
@@ -1576,7 +1743,8 @@ void nanny(struct descriptor_data *d, char *arg)
         load_room = r_frozen_start_room;
 
       send_to_char(d->character, "%s", WELC_MESSG.c_str());
-      character_list.push_back(d->character);
+      d->character->list_pos = character_list.insert(character_list.end(), d->character);
+      start_point_update(d->character);
 
       char_to_room(d->character, load_room);
       load_result = Crash_load(d->character);
@@ -1589,6 +1757,8 @@ void nanny(struct descriptor_data *d, char *arg)
       act("$n has entered the game.", TRUE, d->character, 0, 0, CommTarget::TO_ROOM);
 
       STATE(d) = CON_PLAYING;
+      resume_affects(d->character);
+      update_zone_players(d->character);
       if (GET_LEVEL(d->character) == 0) {
 	do_start(d->character);
 	send_to_char(d->character, "%s", START_MESSG.c_str());
@@ -1640,27 +1810,12 @@ void nanny(struct descriptor_data *d, char *arg)
   }
 
   case CON_CHPWD_GETOLD:
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
-      echo_on(d);
-      write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU.c_str());
-      STATE(d) = CON_MENU;
-    } else {
-      write_to_output(d, "\r\nEnter a new password: ");
-      STATE(d) = CON_CHPWD_GETNEW;
-    }
+    verify_password(d, arg, GET_PASSWD(d->character));
     return;
 
   case CON_DELCNF1:
     echo_on(d);
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
-      write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU.c_str());
-      STATE(d) = CON_MENU;
-    } else {
-      write_to_output(d, "\r\nYOU ARE ABOUT TO DELETE THIS CHARACTER PERMANENTLY.\r\n"
-		"ARE YOU ABSOLUTELY SURE?\r\n\r\n"
-		"Please type \"yes\" to confirm: ");
-      STATE(d) = CON_DELCNF2;
-    }
+    verify_password(d, arg, GET_PASSWD(d->character));
     break;
 
   case CON_DELCNF2:
@@ -1695,6 +1850,10 @@ void nanny(struct descriptor_data *d, char *arg)
   case CON_CLOSE:
     break;
 
+  /* game_loop() holds their input back until the hash is in. */
+  case CON_VERIFYING:
+    break;
+
   default:
     basic_mud_log("SYSERR: Nanny: illegal state of con'ness (%d) for '%s'; closing connection.",
 	STATE(d), d->character ? GET_NAME(d->character) : "<unknown>");
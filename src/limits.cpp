@@ -20,6 +20,8 @@
 #include "interpreter.h"
 #include "class.h"
 #include "limits_c.h"
+#include "timer_wheel.h"
+#include "simulate.h"
 
 /* external variables */
 extern int max_exp_gain;
@@ -275,6 +277,7 @@ void gain_exp(struct char_data *ch, int gain)
     }
 
     if (is_altered) {
+      update_zone_players(ch);
       mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE, "%s advanced %d level%s to level %d.",
 		GET_NAME(ch), num_levels, num_levels == 1 ? "" : "s", GET_LEVEL(ch));
       if (num_levels == 1)
@@ -313,6 +316,7 @@ void gain_exp_regardless(struct char_data *ch, int gain)
     }
 
     if (is_altered) {
+      update_zone_players(ch);
       mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE, "%s advanced %d level%s to level %d.",
 		GET_NAME(ch), num_levels, num_levels == 1 ? "" : "s", GET_LEVEL(ch));
       if (num_levels == 1)
@@ -389,6 +393,7 @@ void check_idling(struct char_data *ch)
 	 */
 	ch->desc->character = NULL;
 	ch->desc = NULL;
+	update_zone_players(ch);
       }
       if (free_rent)
 	Crash_rentsave(ch, 0);
@@ -402,82 +407,106 @@ void check_idling(struct char_data *ch)
 
 
 
-/* Update PCs, NPCs, and objects */
-void point_update(void)
+/*
+ * The hourly update of one character: hunger and thirst, getting back
+ * hit points, mana and moves, and for players their lights and idling.
+ * Each character keeps an hour of their own, begun at a random point of
+ * the first, so the world isn't all updated on the same pulse.
+ */
+static void point_update(struct char_data *i)
 {
-  struct char_data *i;
-  struct obj_data *j,  *jj, *next_thing2;
-
-  /* characters */
-  for (auto it = character_list.begin(); it != character_list.end(); ++it) {
-    i = *it;
-
-    gain_condition(i, FULL, -1);
-    gain_condition(i, DRUNK, -1);
-    gain_condition(i, THIRST, -1);
-	
-    if (GET_POS(i) >= POS_STUNNED) {
-      GET_HIT(i) = MIN(GET_HIT(i) + hit_gain(i), GET_MAX_HIT(i));
-      GET_MANA(i) = MIN(GET_MANA(i) + mana_gain(i), GET_MAX_MANA(i));
-      GET_MOVE(i) = MIN(GET_MOVE(i) + move_gain(i), GET_MAX_MOVE(i));
-      if (AFF_FLAGGED(i, AFF_POISON))
-	if (damage(i, i, 2, SPELL_POISON) == -1)
-	  continue;	/* Oops, they died. -gg 6/24/98 */
-      if (GET_POS(i) <= POS_STUNNED)
-	update_pos(i);
-    } else if (GET_POS(i) == POS_INCAP) {
-      if (damage(i, i, 1, TYPE_SUFFERING) == -1)
-	continue;
-    } else if (GET_POS(i) == POS_MORTALLYW) {
-      if (damage(i, i, 2, TYPE_SUFFERING) == -1)
-	continue;
-    }
-    if (!IS_NPC(i)) {
-      update_char_objects(i);
-      if (GET_LEVEL(i) < idle_max_level)
-	check_idling(i);
-    }
+  sim_stopwatch timing(SIM_POINT_UPDATE);
+
+  if (MOB_FLAGGED(i, MOB_NOTDEADYET) || PLR_FLAGGED(i, PLR_NOTDEADYET))
+    return;
+
+  gain_condition(i, FULL, -1);
+  gain_condition(i, DRUNK, -1);
+  gain_condition(i, THIRST, -1);
+
+  if (GET_POS(i) >= POS_STUNNED) {
+    GET_HIT(i) = MIN(GET_HIT(i) + hit_gain(i), GET_MAX_HIT(i));
+    GET_MANA(i) = MIN(GET_MANA(i) + mana_gain(i), GET_MAX_MANA(i));
+    GET_MOVE(i) = MIN(GET_MOVE(i) + move_gain(i), GET_MAX_MOVE(i));
+    if (AFF_FLAGGED(i, AFF_POISON))
+      if (damage(i, i, 2, SPELL_POISON) == -1)
+	return;	/* Oops, they died. -gg 6/24/98 */
+    if (GET_POS(i) <= POS_STUNNED)
+      update_pos(i);
+  } else if (GET_POS(i) == POS_INCAP) {
+    if (damage(i, i, 1, TYPE_SUFFERING) == -1)
+      return;
+  } else if (GET_POS(i) == POS_MORTALLYW) {
+    if (damage(i, i, 2, TYPE_SUFFERING) == -1)
+      return;
+  }
+  if (!IS_NPC(i)) {
+    update_char_objects(i);
+    if (GET_LEVEL(i) < idle_max_level)
+      check_idling(i);
   }
+}
 
-  /* objects */
-  for (auto it = object_list.begin(); it != object_list.end(); ++it) {
-    j = *it;
 
-    /* If this is a corpse */
-    if (IS_CORPSE(j)) {
-      /* timer count down */
-      if (GET_OBJ_TIMER(j) > 0) {
-      	GET_OBJ_TIMER(j)--;
-      }
+/* Called as a character enters the game; extract_char_final() stops it. */
+void start_point_update(struct char_data *ch)
+{
+  cancel_timer(ch->tick);
+  ch->tick = add_timer(rand_number(1, PULSE_MUD_HOUR), [ch] {
+      point_update(ch);
+      return (PULSE_MUD_HOUR);
+    });
+}
 
-      if (!GET_OBJ_TIMER(j)) {
-        if (j->carried_by) {
-          act("$p decays in your hands.", FALSE, j->carried_by, j, 0, CommTarget::TO_CHAR);
-        }
-        else if ((IN_ROOM(j) != NOWHERE) && !(world[IN_ROOM(j)].people.empty())) {
-          act("A quivering horde of maggots consumes $p.", TRUE, world[IN_ROOM(j)].people.front(), j, 0, CommTarget::TO_ROOM);
-          act("A quivering horde of maggots consumes $p.", TRUE, world[IN_ROOM(j)].people.front(), j, 0, CommTarget::TO_CHAR);
-        }
-        for (jj = j->contains; jj; jj = next_thing2) {
-
-          next_thing2 = jj->next_content;	/* Next in inventory */
-          obj_from_obj(jj);
-
-          if (j->in_obj) {
-            obj_to_obj(jj, j->in_obj);
-          }
-          else if (j->carried_by) {
-            obj_to_room(jj, IN_ROOM(j->carried_by));
-          }
-          else if (IN_ROOM(j) != NOWHERE) {
-            obj_to_room(jj, IN_ROOM(j));
-          }
-          else {
-            core_dump();
-          }
-        }
-        extract_obj(j);
-      }
+
+/* One hour closer to rot; returns how long until the next, or 0 if gone. */
+static long corpse_decay(struct obj_data *j)
+{
+  struct obj_data *jj, *next_thing2;
+
+  /* timer count down */
+  if (GET_OBJ_TIMER(j) > 0) {
+    GET_OBJ_TIMER(j)--;
+  }
+
+  if (GET_OBJ_TIMER(j)) {
+    return (PULSE_MUD_HOUR);
+  }
+
+  if (j->carried_by) {
+    act("$p decays in your hands.", FALSE, j->carried_by, j, 0, CommTarget::TO_CHAR);
+  }
+  else if ((IN_ROOM(j) != NOWHERE) && !(world[IN_ROOM(j)].people.empty())) {
+    act("A quivering horde of maggots consumes $p.", TRUE, world[IN_ROOM(j)].people.front(), j, 0, CommTarget::TO_ROOM);
+    act("A quivering horde of maggots consumes $p.", TRUE, world[IN_ROOM(j)].people.front(), j, 0, CommTarget::TO_CHAR);
+  }
+  for (jj = j->contains; jj; jj = next_thing2) {
+
+    next_thing2 = jj->next_content;	/* Next in inventory */
+    obj_from_obj(jj);
+
+    if (j->in_obj) {
+      obj_to_obj(jj, j->in_obj);
+    }
+    else if (j->carried_by) {
+      obj_to_room(jj, IN_ROOM(j->carried_by));
+    }
+    else if (IN_ROOM(j) != NOWHERE) {
+      obj_to_room(jj, IN_ROOM(j));
+    }
+    else {
+      core_dump();
     }
   }
+  extract_obj(j);	/* which cancels this event */
+
+  return (0);
+}
+
+
+/* Corpses rot an hour at a time from when they were made. */
+void start_corpse_decay(struct obj_data *corpse)
+{
+  cancel_timer(corpse->tick);
+  corpse->tick = add_timer(PULSE_MUD_HOUR, [corpse] { return (corpse_decay(corpse)); });
 }
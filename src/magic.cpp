@@ -22,6 +22,7 @@
 #include "constants.h"
 #include "class.h"
 #include "config.h"
+#include "simulate.h"
 
 /* external functions */
 void clearMemory(struct char_data *ch);
@@ -66,33 +67,31 @@ int mag_savingthrow(struct char_data *ch, int type, int modifier)
 }
 
 
-/* affect_update: called from comm.c (causes spells to wear off) */
+/*
+ * affect_update: called from comm.c (causes spells to wear off)
+ *
+ * Only the affects running out this hour are looked at: they are the
+ * ones at the front of affect_timers.
+ */
 void affect_update(void)
 {
-  struct char_data *i;
+  sim_stopwatch timing(SIM_AFFECT_UPDATE);
 
-  for (auto it = character_list.begin(); it != character_list.end(); ++it) {
-    i = *it;
+  affect_hour++;
 
-    for (auto af = i->affected.begin(); af != i->affected.end(); ++af) {      
-      if (af->duration >= 1) {
-        af->duration--;
-      }
-      else if (af->duration == -1)	{ /* No action */
-        af->duration = -1;	/* GODs only! unlimited */
-      }
-      else {
-	    if ((af->type > 0) && (af->type <= MAX_SPELLS)) {
-          auto next = std::next(af, 1);
-	      if ((next == i->affected.end() || (next->type != af->type) || (next->duration > 0))) {
-	        if (spell_info[af->type].wear_off_msg) {
-	          send_to_char(i, "%s\r\n", spell_info[af->type].wear_off_msg);
-	        }
-	        affect_remove(i, *af);
-	      }
-        }
-      }
+  while (!affect_timers.empty() && affect_timers.begin()->first <= affect_hour) {
+    struct char_data *i = affect_timers.begin()->second.first;
+    struct char_affect *af = affect_timers.begin()->second.second;
+
+    if ((af->type > 0) && (af->type <= MAX_SPELLS) && spell_info[af->type].wear_off_msg) {
+      auto it = std::find_if(i->affected.begin(), i->affected.end(), [&af](const char_affect &a) { return &a == af; });
+      auto next = std::next(it, 1);
+
+      /* One message for all of a spell's affects that run out together. */
+      if (next == i->affected.end() || next->type != af->type || next->expires != affect_hour)
+        send_to_char(i, "%s\r\n", spell_info[af->type].wear_off_msg);
     }
+    affect_remove(i, *af);
   }
 }
 
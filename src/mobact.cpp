@@ -21,9 +21,11 @@
 #include "spells.h"
 #include "constants.h"
 #include "act.h"
+#include "simulate.h"
 
 /* external globals */
 extern int no_specials;
+extern bool idle_empty_zones;
 
 /* external functions */
 ACMD(do_get);
@@ -38,6 +40,7 @@ bool aggressive_mob_on_a_leash(struct char_data *slave, struct char_data *master
 
 void mobile_activity(void)
 {
+  sim_stopwatch timing(SIM_MOBILE_ACTIVITY);
   struct char_data *ch, *vict;
   struct obj_data *obj, *best_obj;
   int door, found, max;
@@ -67,6 +70,9 @@ void mobile_activity(void)
       continue;
     }
 
+    if (idle_empty_zones && zone_table[world[IN_ROOM(ch)].zone].players == 0)
+      continue;
+
     /* Scavenger (picking up objects) */
     if (MOB_FLAGGED(ch, MOB_SCAVENGER))
       if (!world[IN_ROOM(ch)].contents.empty() && !rand_number(0, 10)) {
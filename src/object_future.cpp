@@ -94,7 +94,7 @@ void object_future::parse_single_idx(const std::string &idx, std::vector<obj_dat
         line.erase(std::remove_if(line.begin(), line.end(), [](char c) { return '~' == c;} ), line.end());
         d.description = strdup(line.c_str());      
 
-        reading.ex_description.push_back(d);
+        reading.ex_description.edit().push_back(d);
 
       } else if ('A' == line.front()) {
         // next, line of 2 integers
@@ -0,0 +1,217 @@
+/*
+ * outbuf.cpp
+ *
+ * The segment chains behind descriptor output.  Segments only ever come
+ * from and go back to the pool on the game thread; the compressor threads
+ * just read the ones they are handed.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <algorithm>
+#include <string>
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "slab_pool.h"
+#include "outbuf.h"
+
+
+static slab_pool &segment_pool(void)
+{
+  static slab_pool *pool = new slab_pool("output", sizeof(out_segment), alignof(out_segment));
+
+  return *pool;
+}
+
+
+void *out_segment::operator new(size_t size)
+{
+  if (size != sizeof(out_segment))
+    return ::operator new(size);
+  return segment_pool().allocate();
+}
+
+
+void out_segment::operator delete(void *p, size_t size)
+{
+  if (size != sizeof(out_segment))
+    ::operator delete(p);
+  else
+    segment_pool().deallocate(p);
+}
+
+
+void free_segments(struct out_segment *list)
+{
+  while (list) {
+    struct out_segment *next = list->next;
+
+    delete list;
+    list = next;
+  }
+}
+
+
+struct out_segment *out_chain::add_segment(void)
+{
+  struct out_segment *seg = new out_segment;
+
+  seg->next = nullptr;
+  seg->start = seg->end = 0;
+
+  if (_tail)
+    _tail->next = seg;
+  else
+    _head = seg;
+  _tail = seg;
+
+  return (seg);
+}
+
+
+void out_chain::append(const char *txt, size_t len)
+{
+  _length += len;
+
+  while (len > 0) {
+    struct out_segment *seg = _tail;
+
+    if (!seg || seg->end == OUT_SEGMENT_SIZE)
+      seg = add_segment();
+
+    size_t n = std::min(len, OUT_SEGMENT_SIZE - seg->end);
+
+    memcpy(seg->data + seg->end, txt, n);
+    seg->end += n;
+    txt += n;
+    len -= n;
+  }
+}
+
+
+void out_chain::append(const char *txt)
+{
+  append(txt, strlen(txt));
+}
+
+
+int out_chain::vformat(size_t limit, const char *format, va_list args)
+{
+  struct out_segment *seg = _tail;
+  size_t room = (seg ? OUT_SEGMENT_SIZE - seg->end : 0);
+  va_list again;
+  int size;
+
+  /* Most text fits in what is left of the last segment: format it there. */
+  va_copy(again, args);
+  size = vsnprintf(room ? seg->data + seg->end : nullptr, room, format, args);
+
+  if (size < 0)
+    size = 0;
+  else if (_length + size > limit)
+    size = -1;
+  else if (static_cast<size_t>(size) < room) {
+    seg->end += size;
+    _length += size;
+  } else if (size < OUT_SEGMENT_SIZE) {
+    seg = add_segment();
+    vsnprintf(seg->data, OUT_SEGMENT_SIZE, format, again);
+    seg->end = size;
+    _length += size;
+  } else {
+    /* Longer than a segment; format it on the side and copy it in. */
+    std::string txt(size + 1, '\0');
+
+    vsnprintf(&txt[0], size + 1, format, again);
+    append(txt.data(), size);
+  }
+  va_end(again);
+
+  return (size);
+}
+
+
+void out_chain::splice(out_chain &other)
+{
+  if (!other._head)
+    return;
+
+  if (_tail)
+    _tail->next = other._head;
+  else
+    _head = other._head;
+  _tail = other._tail;
+  _length += other._length;
+
+  other._head = other._tail = nullptr;
+  other._length = 0;
+}
+
+
+void out_chain::copy_to(out_chain &dest, size_t len) const
+{
+  for (const struct out_segment *seg = _head; seg && len > 0; seg = seg->next) {
+    size_t n = std::min(len, seg->end - seg->start);
+
+    dest.append(seg->data + seg->start, n);
+    len -= n;
+  }
+}
+
+
+int out_chain::fill_iovecs(struct iovec *iov, int max) const
+{
+  int n = 0;
+
+  for (const struct out_segment *seg = _head; seg && n < max; seg = seg->next, n++) {
+    iov[n].iov_base = const_cast<char *>(seg->data + seg->start);
+    iov[n].iov_len = seg->end - seg->start;
+  }
+
+  return (n);
+}
+
+
+void out_chain::consume(size_t len)
+{
+  len = std::min(len, _length);
+  _length -= len;
+
+  while (len > 0) {
+    size_t n = std::min(len, _head->end - _head->start);
+
+    _head->start += n;
+    len -= n;
+
+    if (_head->start == _head->end) {
+      struct out_segment *next = _head->next;
+
+      delete _head;
+      if (!(_head = next))
+	_tail = nullptr;
+    }
+  }
+}
+
+
+struct out_segment *out_chain::release(void)
+{
+  struct out_segment *list = _head;
+
+  _head = _tail = nullptr;
+  _length = 0;
+
+  return (list);
+}
+
+
+void out_chain::clear(void)
+{
+  free_segments(release());
+}
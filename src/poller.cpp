@@ -0,0 +1,259 @@
+/*
+ * poller.cpp
+ *
+ * select() and epoll backends for the poller interface used by game_loop().
+ * create_poller() picks epoll when the system has it and falls back to
+ * select() otherwise.
+ */
+
+#define __POLLER_C__
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <vector>
+
+#include "structs.h"
+#include "utils.h"
+#include "poller.h"
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+
+/*
+ * The classic backend.  The fd_sets of registered and armed descriptors are
+ * kept up to date by add/remove/want_output, so each pass only copies them.
+ */
+class select_poller final : public poller {
+  fd_set registered, armed;
+  fd_set input_set, output_set, exc_set;
+  socket_t listener = INVALID_SOCKET;
+  socket_t maxdesc = 0;
+
+public:
+  select_poller()
+  {
+    FD_ZERO(&registered);
+    FD_ZERO(&armed);
+    FD_ZERO(&input_set);
+    FD_ZERO(&output_set);
+    FD_ZERO(&exc_set);
+  }
+
+  bool add_listener(socket_t s) final
+  {
+    if (!add(s))
+      return (false);
+    listener = s;
+    return (true);
+  }
+
+  bool add(socket_t s) final
+  {
+#ifndef CIRCLE_WINDOWS
+    if (s >= FD_SETSIZE) {
+      basic_mud_log("SYSERR: descriptor %d is beyond FD_SETSIZE (%d).", (int) s, FD_SETSIZE);
+      return (false);
+    }
+    if (s > maxdesc)
+      maxdesc = s;
+#endif
+    FD_SET(s, &registered);
+    FD_CLR(s, &armed);
+    return (true);
+  }
+
+  void remove(socket_t s) final
+  {
+    FD_CLR(s, &registered);
+    FD_CLR(s, &armed);
+    FD_CLR(s, &input_set);
+    FD_CLR(s, &output_set);
+    FD_CLR(s, &exc_set);
+#ifndef CIRCLE_WINDOWS
+    while (maxdesc > 0 && !FD_ISSET(maxdesc, &registered))
+      maxdesc--;
+#endif
+  }
+
+  void want_output(socket_t s, bool want) final
+  {
+    if (want)
+      FD_SET(s, &armed);
+    else
+      FD_CLR(s, &armed);
+  }
+
+  /* select() is level-triggered; the next pass will report it again. */
+  void input_drained(socket_t s) final { (void) s; }
+
+  int wait(struct timeval *timeout) final
+  {
+    input_set = registered;
+    output_set = armed;
+    exc_set = registered;
+    if (listener != INVALID_SOCKET)
+      FD_CLR(listener, &exc_set);
+
+    int result = select(maxdesc + 1, &input_set, &output_set, &exc_set, timeout);
+    if (result < 0) {
+      FD_ZERO(&input_set);
+      FD_ZERO(&output_set);
+      FD_ZERO(&exc_set);
+    }
+    return (result);
+  }
+
+  bool readable(socket_t s) const final { return FD_ISSET(s, &input_set); }
+  bool writable(socket_t s) const final { return !FD_ISSET(s, &armed) || FD_ISSET(s, &output_set); }
+  bool exception(socket_t s) const final { return FD_ISSET(s, &exc_set); }
+
+  const char *name(void) const final { return "select"; }
+};
+
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/*
+ * Edge-triggered epoll backend.  Readiness is latched per descriptor when
+ * an edge arrives and only cleared once the game has consumed it (input
+ * read until EAGAIN, output flushed or re-armed), so no pass ever has to
+ * look at sockets that have nothing to say.
+ */
+class epoll_poller final : public poller {
+  enum : unsigned char {
+    IN_READY  = (1 << 0),
+    OUT_ARMED = (1 << 1),
+    OUT_READY = (1 << 2),
+    EXC_READY = (1 << 3)
+  };
+  static const uint32_t DESC_EVENTS = EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLET;
+  static const int EVENT_BATCH = 256;
+
+  int epfd;
+  socket_t listener = INVALID_SOCKET;
+  std::vector<unsigned char> state;
+  std::vector<struct epoll_event> events;
+
+  unsigned char &state_of(socket_t s)
+  {
+    if ((size_t) s >= state.size())
+      state.resize(s + 1, 0);
+    return state[s];
+  }
+
+  unsigned char peek(socket_t s) const
+  {
+    return ((size_t) s < state.size() ? state[s] : 0);
+  }
+
+  bool control(int op, socket_t s, uint32_t mask)
+  {
+    struct epoll_event ev;
+
+    ev.events = mask;
+    ev.data.fd = s;
+    if (epoll_ctl(epfd, op, s, &ev) < 0) {
+      perror("SYSERR: epoll_ctl");
+      return (false);
+    }
+    return (true);
+  }
+
+public:
+  explicit epoll_poller(int fd) : epfd(fd), events(EVENT_BATCH) {}
+  ~epoll_poller() { close(epfd); }
+
+  bool add_listener(socket_t s) final
+  {
+    if (!control(EPOLL_CTL_ADD, s, EPOLLIN))
+      return (false);
+    state_of(s) = 0;
+    listener = s;
+    return (true);
+  }
+
+  bool add(socket_t s) final
+  {
+    if (!control(EPOLL_CTL_ADD, s, DESC_EVENTS))
+      return (false);
+    state_of(s) = 0;
+    return (true);
+  }
+
+  void remove(socket_t s) final
+  {
+    control(EPOLL_CTL_DEL, s, 0);
+    state_of(s) = 0;
+  }
+
+  void want_output(socket_t s, bool want) final
+  {
+    unsigned char &st = state_of(s);
+
+    if (want) {
+      /* Whatever edge we had was used up by the short write. */
+      st &= ~OUT_READY;
+      if (!(st & OUT_ARMED) && control(EPOLL_CTL_MOD, s, DESC_EVENTS | EPOLLOUT))
+        st |= OUT_ARMED;
+    } else if (st & OUT_ARMED) {
+      control(EPOLL_CTL_MOD, s, DESC_EVENTS);
+      st &= ~(OUT_ARMED | OUT_READY);
+    }
+  }
+
+  void input_drained(socket_t s) final { state_of(s) &= ~IN_READY; }
+
+  int wait(struct timeval *timeout) final
+  {
+    int timeout_ms = timeout ? timeout->tv_sec * 1000 + timeout->tv_usec / 1000 : -1;
+    int total = 0, n;
+
+    /* The listener is level-triggered, so it is re-reported every wait. */
+    if (listener != INVALID_SOCKET)
+      state_of(listener) &= ~IN_READY;
+
+    do {
+      if ((n = epoll_wait(epfd, &events[0], events.size(), timeout_ms)) < 0)
+        return (-1);
+
+      for (int i = 0; i < n; i++) {
+        unsigned char &st = state_of(events[i].data.fd);
+        uint32_t ev = events[i].events;
+
+        if (ev & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))
+          st |= IN_READY;
+        if (ev & EPOLLOUT)
+          st |= OUT_READY;
+        if (ev & (EPOLLERR | EPOLLPRI))
+          st |= EXC_READY;
+      }
+      total += n;
+      timeout_ms = 0;
+    } while (n == (int) events.size());
+
+    return (total);
+  }
+
+  bool readable(socket_t s) const final { return (peek(s) & IN_READY); }
+  bool writable(socket_t s) const final { return !(peek(s) & OUT_ARMED) || (peek(s) & OUT_READY); }
+  bool exception(socket_t s) const final { return (peek(s) & EXC_READY); }
+
+  const char *name(void) const final { return "epoll"; }
+};
+
+#endif /* HAVE_SYS_EPOLL_H */
+
+
+poller *create_poller(void)
+{
+#ifdef HAVE_SYS_EPOLL_H
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+  if (epfd >= 0)
+    return new epoll_poller(epfd);
+  perror("SYSERR: epoll_create1, falling back to select()");
+#endif
+  return new select_poller;
+}
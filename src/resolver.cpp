@@ -0,0 +1,66 @@
+/*
+ * resolver.cpp
+ *
+ * The worker pool behind resolve_host().  game_loop() drains the answers
+ * once per pass through check_resolved_hosts().
+ */
+
+#define __RESOLVER_C__
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <memory>
+
+#include "structs.h"
+#include "utils.h"
+#include "resolver.h"
+#include "worker_pool.h"
+
+static std::unique_ptr<worker_pool<struct sockaddr_in, std::string> > resolver;
+
+
+static std::string lookup_host(const struct sockaddr_in &peer)
+{
+  char host[NI_MAXHOST];
+
+  /* getnameinfo() is reentrant, unlike gethostbyaddr(). */
+  if (getnameinfo((const struct sockaddr *) &peer, sizeof(peer), host, sizeof(host), NULL, 0, NI_NAMEREQD) != 0)
+    return std::string();
+
+  return std::string(host);
+}
+
+
+void init_resolver(int threads)
+{
+  resolver.reset(new worker_pool<struct sockaddr_in, std::string>(lookup_host, threads));
+}
+
+
+/*
+ * Lookups still queued are abandoned; a worker blocked in getnameinfo()
+ * is waited for, which only happens at shutdown.
+ */
+void shutdown_resolver(void)
+{
+  resolver.reset();
+}
+
+
+unsigned long resolve_host(const struct in_addr *addr)
+{
+  struct sockaddr_in peer;
+
+  memset((char *) &peer, 0, sizeof(peer));
+  peer.sin_family = AF_INET;
+  peer.sin_addr = *addr;
+
+  return resolver->submit(peer);
+}
+
+
+bool collect_resolved_host(unsigned long *ticket, std::string &name)
+{
+  return resolver && resolver->collect(*ticket, name);
+}
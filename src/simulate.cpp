@@ -0,0 +1,291 @@
+/*
+ * simulate.cpp
+ *
+ * The -b mode: game_loop() without the sockets, the sleeping or the wall
+ * clock.  Each pulse the scripted players have their turn, as they would
+ * in a pass of game_loop(), and then heartbeat() runs and it's straight
+ * on to the next pulse.  The seed and the game clock are fixed, so the
+ * same world, pulses and players make the same run every time.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <vector>
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "db.h"
+#include "handler.h"
+#include "interpreter.h"
+#include "class.h"
+#include "act.h"
+#include "simulate.h"
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+
+#define SIM_SEED	1	/* any fixed number will do */
+
+/* external variables */
+extern long top_idnum;
+
+/* external functions */
+void heartbeat(void);
+void start_heartbeat(void);
+void show_string(struct descriptor_data *d, char *input);
+
+long sim_pulses = 0;
+
+/*
+ * What the simulated players do, over and over.  Each starts on a
+ * different line and thinks for a different time between lines, so they
+ * spread out around the city instead of marching about in step.
+ */
+static const char *sim_script[] = {
+  "look", "south", "kill fido", "score", "south", "kill cityguard",
+  "get all", "east", "kill janitor", "who", "west", "north", "say hello",
+  "north", "inventory", "flee", "west", "kill beastly", "east",
+  "equipment", "north", "kill cityguard", "south", "time", "east",
+  "kill dog", "west", "look", "down", "up"
+};
+
+#define SIM_SCRIPT_LINES	(sizeof(sim_script) / sizeof(sim_script[0]))
+
+struct sim_player {
+  struct descriptor_data *d;	/* never on descriptor_list		*/
+  size_t line;			/* next line of sim_script		*/
+  int think;			/* pulses from one line to the next	*/
+  int wait;			/* pulses until the next line		*/
+};
+
+static const char *sim_part_names[NUM_SIM_PARTS] = {
+  "commands",
+  "zone_update",
+  "zone resets",
+  "mobile_activity",
+  "perform_violence",
+  "point_update",
+  "affect_update",
+  "extractions"
+};
+
+static unsigned long sim_runs[NUM_SIM_PARTS];
+static std::chrono::steady_clock::duration sim_spent[NUM_SIM_PARTS];
+
+
+void sim_record(int part, std::chrono::steady_clock::duration spent)
+{
+  sim_runs[part]++;
+  sim_spent[part] += spent;
+}
+
+
+/*
+ * A new level 1 character, logged in and ready at the menu.  Nothing of
+ * theirs goes to the player file: with no file position save_char()
+ * passes them by, and since their descriptor isn't on descriptor_list
+ * neither does Crash_save_all().
+ */
+static struct descriptor_data *new_sim_player(int num)
+{
+  struct descriptor_data *d = new descriptor_data();
+  struct char_data *ch = new char_data;
+  char name[MAX_NAME_LENGTH + 1];
+
+  d->descriptor = INVALID_SOCKET;
+  strlcpy(d->host, "simulation", sizeof(d->host));
+  d->login_time = time(0);
+  d->history = new char*[HISTORY_SIZE]();
+  STATE(d) = CON_MENU;
+
+  clear_char(ch);
+  ch->player_specials = new player_special_data;
+
+  /* What a player file would fill in starts out as nothing at all. */
+  ch->points = char_point_data();
+  ch->char_specials.saved = char_special_data_saved();
+  ch->player_specials->saved = player_special_data_saved();
+
+  snprintf(name, sizeof(name), "Sim%d", num);
+  ch->player.name = name;
+  GET_SEX(ch) = (num % 2 ? SEX_FEMALE : SEX_MALE);
+  GET_CLASS(ch) = num % NUM_CLASSES;
+  GET_IDNUM(ch) = ++top_idnum;
+  ch->player.time.birth = ch->player.time.logon = time(0);
+  GET_LOADROOM(ch) = NOWHERE;
+  do_start(ch);
+
+  ch->desc = d;
+  d->character = ch;
+
+  return (d);
+}
+
+
+/* Menu option 1, as nanny() does it: in at the mortal start room. */
+static void enter_game(struct descriptor_data *d)
+{
+  struct char_data *ch = d->character;
+
+  reset_char(ch);
+  ch->list_pos = character_list.insert(character_list.end(), ch);
+  start_point_update(ch);
+  char_to_room(ch, r_mortal_start_room);
+
+  act("$n has entered the game.", TRUE, ch, 0, 0, CommTarget::TO_ROOM);
+
+  STATE(d) = CON_PLAYING;
+  resume_affects(ch);
+  update_zone_players(ch);
+  look_at_room(ch, 0);
+}
+
+
+/* One player's part of a pass of game_loop(); returns TRUE if they died. */
+static int run_sim_player(struct sim_player &p)
+{
+  struct descriptor_data *d = p.d;
+  struct char_data *ch = d->character;
+  char comm[MAX_INPUT_LENGTH];
+  int died = FALSE;
+
+  /* Dead players are back at the menu, and go straight back in. */
+  if (STATE(d) != CON_PLAYING) {
+    enter_game(d);
+    died = TRUE;
+  }
+
+  GET_WAIT_STATE(ch) -= (GET_WAIT_STATE(ch) > 0);
+  if (GET_WAIT_STATE(ch) || --p.wait > 0)
+    return (died);
+  p.wait = p.think;
+
+  ch->char_specials.timer = 0;
+  GET_WAIT_STATE(ch) = 1;
+
+  if (d->showstr_count) {	/* Return for the next page. */
+    *comm = '\0';
+    show_string(d, comm);
+  } else {
+    strlcpy(comm, sim_script[p.line], sizeof(comm));
+    p.line = (p.line + 1) % SIM_SCRIPT_LINES;
+    command_interpreter(ch, comm);
+  }
+
+  return (died);
+}
+
+
+static void free_sim_player(struct descriptor_data *d)
+{
+  int cnt;
+
+  free_char(d->character);
+
+  for (cnt = 0; cnt < HISTORY_SIZE; cnt++)
+    if (d->history[cnt])
+      delete [] d->history[cnt];
+  delete [] d->history;
+
+  if (d->showstr_head)
+    free(d->showstr_head);
+  if (d->showstr_count)
+    free(d->showstr_vector);
+
+  delete d;
+}
+
+
+static double ms(std::chrono::steady_clock::duration spent)
+{
+  return (std::chrono::duration<double, std::milli>(spent).count());
+}
+
+
+static void sim_report(long pulses, int players, std::chrono::steady_clock::duration total, int deaths)
+{
+  std::chrono::steady_clock::duration other = total;
+  int i;
+
+  printf("\n%ld pulses (%ld game seconds) with %d player(s) in %.3f s: %.0f pulses a second.\n\n",
+	pulses, pulses / PASSES_PER_SEC, players, ms(total) / 1000,
+	pulses / std::max(ms(total) / 1000, 1e-9));
+
+  printf("  %-18s %10s %12s %10s %7s\n", "part", "runs", "total ms", "us a run", "share");
+  for (i = 0; i < NUM_SIM_PARTS; i++) {
+    printf("  %-18s %10lu %12.2f %10.2f %6.1f%%\n", sim_part_names[i], sim_runs[i],
+	ms(sim_spent[i]), sim_runs[i] ? ms(sim_spent[i]) * 1000 / sim_runs[i] : 0.0,
+	100 * ms(sim_spent[i]) / std::max(ms(total), 1e-9));
+    other -= sim_spent[i];
+  }
+  printf("  %-18s %10s %12.2f %10s %6.1f%%\n", "other", "", ms(other), "",
+	100 * ms(other) / std::max(ms(total), 1e-9));
+
+  /* Any difference in what happened shows up here. */
+  printf("\nAt the end: %zu characters, %zu objects, %d player death(s); next random number %lu.\n",
+	character_list.size(), object_list.size(), deaths, circle_random());
+}
+
+
+/* Boot, run 'pulses' pulses as fast as they'll go, report, and clean up. */
+void simulate_game(long pulses, int players)
+{
+  std::vector<struct sim_player> sim_players;
+  std::chrono::steady_clock::time_point start;
+  long pulse;
+  int i, deaths = 0;
+
+  circle_srandom(SIM_SEED);
+
+  boot_db();
+
+  for (i = 0; i < players; i++) {
+    struct sim_player p;
+
+    p.d = new_sim_player(i + 1);
+    p.line = i % SIM_SCRIPT_LINES;
+    p.think = 5 + i % 11;
+    p.wait = 1 + i % p.think;
+    sim_players.push_back(p);
+    enter_game(p.d);
+  }
+
+  /* Only the pulses count, not the boot. */
+  for (i = 0; i < NUM_SIM_PARTS; i++) {
+    sim_runs[i] = 0;
+    sim_spent[i] = std::chrono::steady_clock::duration::zero();
+  }
+
+  basic_mud_log("Simulating %ld pulses with %d player(s).", pulses, players);
+  start_heartbeat();
+  start = std::chrono::steady_clock::now();
+
+  for (pulse = 0; pulse < pulses; pulse++) {
+    {
+      sim_stopwatch timing(SIM_COMMANDS);
+
+      for (struct sim_player &p : sim_players) {
+	deaths += run_sim_player(p);
+
+	/* Made, then thrown away: there is no one on the other end. */
+	p.d->output.consume(p.d->output.length());
+	p.d->overflow = false;
+      }
+    }
+
+    heartbeat();
+  }
+
+  sim_report(pulses, players, std::chrono::steady_clock::now() - start, deaths);
+
+  for (struct sim_player &p : sim_players)
+    if (STATE(p.d) == CON_PLAYING)
+      extract_char(p.d->character);
+  extract_pending_chars();
+
+  for (struct sim_player &p : sim_players)
+    free_sim_player(p.d);
+}
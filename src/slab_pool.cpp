@@ -0,0 +1,60 @@
+/*
+ * slab_pool.cpp
+ *
+ * Slab bookkeeping for the pools in slab_pool.h.  Slabs are never handed
+ * back: a pool stays as big as the busiest moment it has seen.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <algorithm>
+
+#include "slab_pool.h"
+
+/* Roughly how much each new slab holds, however big the slots. */
+#define SLAB_BYTES	65536
+#define SLAB_MIN_SLOTS	16
+
+
+static std::vector<slab_pool *> &pools(void)
+{
+  static std::vector<slab_pool *> *list = new std::vector<slab_pool *>;
+
+  return *list;
+}
+
+
+const std::vector<slab_pool *> &slab_pool::all(void)
+{
+  return pools();
+}
+
+
+slab_pool::slab_pool(const char *name, size_t size, size_t align) : _name(name)
+{
+  align = std::max(align, alignof(free_slot));
+  size = std::max(size, sizeof(free_slot));
+
+  _slot_size = (size + align - 1) / align * align;
+  _slots_per_slab = std::max<size_t>(SLAB_MIN_SLOTS, SLAB_BYTES / _slot_size);
+
+  pools().push_back(this);
+}
+
+
+/* operator new memory is aligned for anything, so every slot is too. */
+void slab_pool::grow(void)
+{
+  char *slab = static_cast<char *>(::operator new(_slot_size * _slots_per_slab));
+
+  _slabs.push_back(slab);
+
+  /* Thread the new slots on in address order, so they get used that way. */
+  for (size_t i = _slots_per_slab; i-- > 0; ) {
+    free_slot *slot = reinterpret_cast<free_slot *>(slab + i * _slot_size);
+
+    slot->next = _free;
+    _free = slot;
+  }
+}
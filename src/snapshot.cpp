@@ -0,0 +1,468 @@
+/*
+ * snapshot.cpp
+ *
+ * Binary world snapshots for boot_world().  Every table is described once,
+ * by an xfer() function that either writes each field into the snapshot or
+ * reads it back, depending on the archive it is handed.
+ */
+
+#define __SNAPSHOT_C__
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <list>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "shop.h"
+#include "snapshot.h"
+
+/*
+ * Bump this whenever a world parser starts setting a field the xfer()
+ * functions below don't carry, or a snapshot made by the old code would
+ * quietly boot without it.
+ */
+#define SNAPSHOT_VERSION	1
+
+struct snapshot_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t layout[8];		/* sizes of everything stored raw */
+  uint8_t mini;
+  uint8_t with_shops;
+};
+
+/* One index or world file the snapshot was made from. */
+struct source_file {
+  std::string path;
+  int64_t size;
+  int64_t mtime;
+
+  bool operator==(const source_file &o) const
+  {
+    return path == o.path && size == o.size && mtime == o.mtime;
+  }
+};
+
+
+class snapshot_writer {
+  std::string _buf;
+
+public:
+  static const bool reading = false;
+
+  template<class T>
+  void operator()(T &v)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data is stored raw");
+    _buf.append((const char *) &v, sizeof(T));
+  }
+
+  void operator()(std::string &s)
+  {
+    uint32_t len = s.size();
+
+    (*this)(len);
+    _buf.append(s);
+  }
+
+  void operator()(shared_string &s)
+  {
+    uint32_t len = s.size();
+
+    (*this)(len);
+    _buf.append(s.str());
+  }
+
+  bool fits(uint32_t count) { return (true); }
+
+  const std::string &data(void) const { return _buf; }
+};
+
+
+/* Any short or inconsistent read just marks the whole snapshot bad. */
+class snapshot_reader {
+  const char *_pos, *_end;
+  bool _ok = true;
+
+  const char *take(size_t len)
+  {
+    if (!_ok || (size_t) (_end - _pos) < len) {
+      _ok = false;
+      return (NULL);
+    }
+    _pos += len;
+    return (_pos - len);
+  }
+
+public:
+  static const bool reading = true;
+
+  explicit snapshot_reader(const std::string &buf) : _pos(buf.data()), _end(buf.data() + buf.size()) {}
+
+  template<class T>
+  void operator()(T &v)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data is stored raw");
+    const char *p = take(sizeof(T));
+
+    if (p)
+      memcpy((void *) &v, p, sizeof(T));
+  }
+
+  void operator()(std::string &s)
+  {
+    uint32_t len = 0;
+    const char *p;
+
+    (*this)(len);
+    if ((p = take(len)) != NULL)
+      s.assign(p, len);
+  }
+
+  void operator()(shared_string &s)
+  {
+    std::string v;
+
+    (*this)(v);
+    s = std::move(v);
+  }
+
+  /* Every element takes at least a byte, so this catches garbage counts. */
+  bool fits(uint32_t count)
+  {
+    if ((size_t) (_end - _pos) < count)
+      _ok = false;
+    return (_ok);
+  }
+
+  bool ok(void) const { return (_ok); }
+  bool done(void) const { return (_ok && _pos == _end); }
+};
+
+
+template<class A, class T>
+static void xfer(A &a, T &v)
+{
+  a(v);
+}
+
+
+template<class A, class C>
+static void xfer_seq(A &a, C &seq)
+{
+  uint32_t count = seq.size();
+
+  a(count);
+  if (!a.fits(count))
+    return;
+
+  seq.resize(count);
+  for (auto &entry : seq)
+    xfer(a, entry);
+}
+
+
+template<class A, class C>
+static void xfer_seq(A &a, shared_value<C> &seq)
+{
+  C entries = seq.get();
+
+  xfer_seq(a, entries);
+  if (A::reading)
+    seq = std::move(entries);
+}
+
+
+template<class A>
+static void xfer(A &a, source_file &f)
+{
+  a(f.path);
+  a(f.size);
+  a(f.mtime);
+}
+
+
+template<class A>
+static void xfer(A &a, extra_descr_data &e)
+{
+  a(e.keyword);
+  a(e.description);
+}
+
+
+template<class A>
+static void xfer(A &a, zone_data &z)
+{
+  a(z.name);
+  a(z.lifespan);
+  a(z.bot);
+  a(z.top);
+  a(z.reset_mode);
+  a(z.number);
+  xfer_seq(a, z.cmd);
+}
+
+
+template<class A>
+static void xfer(A &a, room_data &r)
+{
+  a(r.number);
+  a(r.zone);
+  a(r.sector_type);
+  a(r.name);
+  a(r.description);
+  a(r.room_flags);
+  xfer_seq(a, r.ex_description);
+
+  for (auto &dir : r.dir_option) {
+    room_direction_data &exit = std::get<0>(dir);
+
+    a(std::get<1>(dir));
+    a(exit.general_description);
+    a(exit.keyword);
+    a(exit.exit_info);
+    a(exit.key);
+    a(exit.to_room);
+  }
+}
+
+
+template<class A>
+static void xfer(A &a, obj_data &o)
+{
+  a(o.item_number);
+  a(o.vnum);
+  a(o.obj_flags);
+  a(o.affected);
+  a(o.name);
+  a(o.description);
+  a(o.short_description);
+  a(o.action_description);
+  xfer_seq(a, o.ex_description);
+}
+
+
+/* Only what mob_future fills in; the rest is left as char_data() has it. */
+template<class A>
+static void xfer(A &a, char_data &m)
+{
+  a(m.nr);
+  a(m.vnr);
+  a(m.player.name);
+  a(m.player.short_descr);
+  a(m.player.long_descr);
+  a(m.player.description);
+  a(m.player.sex);
+  a(m.player.chclass);
+  a(m.player.level);
+  a(m.player.weight);
+  a(m.player.height);
+  a(m.real_abils);
+  a(m.aff_abils);
+  a(m.points);
+  a(m.char_specials.position);
+  a(m.char_specials.saved);
+  a(m.mob_specials.attack_type);
+  a(m.mob_specials.default_pos);
+  a(m.mob_specials.damnodice);
+  a(m.mob_specials.damsizedice);
+
+  if (A::reading)
+    m.player_specials = &dummy_mob;
+}
+
+
+template<class A>
+static void xfer(A &a, shop_buy_data &b)
+{
+  std::string keywords(b.keywords ? b.keywords : "");
+
+  a(b.type);
+  a(keywords);
+  if (A::reading)
+    b.keywords = strdup(keywords.c_str());
+}
+
+
+template<class A>
+static void xfer(A &a, shop_data &s)
+{
+  a(s.vnum);
+  xfer_seq(a, s.producing);
+  a(s.profit_buy);
+  a(s.profit_sell);
+  xfer_seq(a, s.type);
+  a(s.no_such_item1);
+  a(s.no_such_item2);
+  a(s.missing_cash1);
+  a(s.missing_cash2);
+  a(s.do_not_buy);
+  a(s.message_buy);
+  a(s.message_sell);
+  a(s.temper1);
+  a(s.bitvector);
+  a(s.keeper);
+  a(s.with_who);
+  xfer_seq(a, s.in_room);
+  a(s.open1);
+  a(s.close1);
+  a(s.open2);
+  a(s.close2);
+}
+
+
+static snapshot_header make_header(bool mini, bool with_shops)
+{
+  snapshot_header h;
+
+  memset(&h, 0, sizeof(h));	/* Padding goes to disk too. */
+  memcpy(h.magic, "CIRCWLD", sizeof(h.magic));
+  h.version = SNAPSHOT_VERSION;
+  h.layout[0] = sizeof(reset_com);
+  h.layout[1] = sizeof(obj_flag_data);
+  h.layout[2] = sizeof(obj_affected_type) * MAX_OBJ_AFFECT;
+  h.layout[3] = sizeof(char_ability_data);
+  h.layout[4] = sizeof(char_point_data);
+  h.layout[5] = sizeof(char_special_data_saved);
+  h.layout[6] = NUM_OF_DIRS;
+  h.layout[7] = sizeof(IDXTYPE);
+  h.mini = mini;
+  h.with_shops = with_shops;
+
+  return (h);
+}
+
+
+/* The same files, in the same order, as the future_parse<> loaders read. */
+static bool list_world_files(bool mini, bool with_shops, std::vector<source_file> &files)
+{
+  const char *prefixes[] = { ZON_PREFIX, OBJ_PREFIX, WLD_PREFIX, MOB_PREFIX, SHP_PREFIX };
+  int count = with_shops ? 5 : 4;
+  std::vector<std::string> paths;
+  struct stat st;
+
+  for (int i = 0; i < count; i++) {
+    std::string index = std::string(prefixes[i]) + (mini ? MINDEX_FILE : INDEX_FILE);
+    std::ifstream idx(index);
+
+    paths.push_back(index);
+    for (std::string line; std::getline(idx, line) && line[0] != '$'; )
+      paths.push_back(prefixes[i] + line);
+  }
+
+  files.clear();
+  for (const auto &path : paths) {
+    if (stat(path.c_str(), &st) < 0)
+      return (false);
+
+    source_file f;
+    f.path = path;
+    f.size = st.st_size;
+    f.mtime = st.st_mtime;
+    files.push_back(f);
+  }
+  return (true);
+}
+
+
+bool load_world_snapshot(bool mini, bool with_shops)
+{
+  const char *fname = mini ? MSNAPSHOT_FILE : SNAPSHOT_FILE;
+  snapshot_header want = make_header(mini, with_shops), have;
+  std::vector<source_file> current, recorded;
+  std::vector<zone_data> zones;
+  std::vector<room_data> rooms;
+  std::vector<obj_data> objs;
+  std::vector<char_data> mobs;
+  std::vector<shop_data> shops;
+  std::ostringstream contents;
+
+  std::ifstream in(fname, std::ios::binary);
+  if (!in)
+    return (false);
+  contents << in.rdbuf();
+  in.close();
+
+  /* Copy the bytes out once; every string has to be copied out anyway. */
+  std::string buf = contents.str();
+  snapshot_reader r(buf);
+
+  r(have);
+  if (!r.ok() || memcmp(&have, &want, sizeof(want))) {
+    basic_mud_log("World snapshot %s was made by other code; ignoring it.", fname);
+    return (false);
+  }
+
+  xfer_seq(r, recorded);
+  if (!list_world_files(mini, with_shops, current) || !r.ok() || recorded != current) {
+    basic_mud_log("World files have changed since %s was made; ignoring it.", fname);
+    return (false);
+  }
+
+  xfer_seq(r, zones);
+  xfer_seq(r, rooms);
+  xfer_seq(r, objs);
+  xfer_seq(r, mobs);
+  if (with_shops)
+    xfer_seq(r, shops);
+
+  if (!r.done()) {
+    basic_mud_log("SYSERR: World snapshot %s is damaged; ignoring it.", fname);
+    for (auto &shop : shops)
+      for (auto &buy : shop.type)
+	free(BUY_WORD(buy));
+    return (false);
+  }
+
+  zone_table.swap(zones);
+  world.swap(rooms);
+  obj_proto.swap(objs);
+  mob_proto.swap(mobs);
+  shop_index.swap(shops);
+
+  return (true);
+}
+
+
+void save_world_snapshot(bool mini, bool with_shops)
+{
+  const char *fname = mini ? MSNAPSHOT_FILE : SNAPSHOT_FILE;
+  std::string tmpname = std::string(fname) + ".new";
+  snapshot_header h = make_header(mini, with_shops);
+  std::vector<source_file> files;
+  snapshot_writer w;
+
+  if (!list_world_files(mini, with_shops, files)) {
+    basic_mud_log("SYSERR: Cannot stat every world file; not writing %s.", fname);
+    return;
+  }
+
+  w(h);
+  xfer_seq(w, files);
+  xfer_seq(w, zone_table);
+  xfer_seq(w, world);
+  xfer_seq(w, obj_proto);
+  xfer_seq(w, mob_proto);
+  if (with_shops)
+    xfer_seq(w, shop_index);
+
+  /* Write it aside and rename, so a crash never leaves half a snapshot. */
+  std::ofstream out(tmpname, std::ios::binary | std::ios::trunc);
+  out.write(w.data().data(), w.data().size());
+  out.close();
+
+  if (!out || rename(tmpname.c_str(), fname) < 0) {
+    basic_mud_log("SYSERR: Cannot write world snapshot %s: %s", fname, strerror(errno));
+    remove(tmpname.c_str());
+    return;
+  }
+  basic_mud_log("   wrote world snapshot %s, %lu bytes.", fname, (unsigned long) w.data().size());
+}
@@ -0,0 +1,207 @@
+/*
+ * timer_wheel.cpp
+ *
+ * The classic hierarchical wheel: a root wheel with a slot per pulse for
+ * the next 256 pulses, and three more wheels of 64 slots, each slot as
+ * long as one whole turn of the wheel below.  An event waits in the
+ * coarsest wheel that can hold it and is moved down a wheel each time
+ * the one below comes round, so it is looked at no more than four times
+ * before it runs.  At ten pulses a second the wheels turn every 25.6
+ * seconds, 27 minutes, 29 hours and 77 days.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <algorithm>
+
+#include "structs.h"
+#include "utils.h"
+#include "slab_pool.h"
+#include "timer_wheel.h"
+
+#define ROOT_BITS	8
+#define WHEEL_BITS	6
+#define WHEELS		3	/* above the root */
+
+#define ROOT_SIZE	(1UL << ROOT_BITS)
+#define WHEEL_SIZE	(1UL << WHEEL_BITS)
+#define MAX_DELAY	((1UL << (ROOT_BITS + WHEELS * WHEEL_BITS)) - 1)
+
+struct timer_event {
+  struct timer_event *next, *prev;
+  struct timer_event **slot;	/* the list we are on, if any	*/
+  unsigned long when;		/* pulse we are due on		*/
+  bool cancelled;		/* cancelled while running	*/
+  timer_func func;
+
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+};
+
+static struct timer_event *root[ROOT_SIZE];
+static struct timer_event *wheels[WHEELS][WHEEL_SIZE];
+static struct timer_event *due;		/* this pulse's events, not yet run */
+static struct timer_event *running;	/* the one being run right now */
+
+static unsigned long next_pulse = 0;	/* the pulse run_timers() runs next */
+static size_t pending = 0;
+
+
+static slab_pool &event_pool(void)
+{
+  static slab_pool *pool = new slab_pool("timers", sizeof(timer_event), alignof(timer_event));
+
+  return *pool;
+}
+
+
+void *timer_event::operator new(size_t size)
+{
+  if (size != sizeof(timer_event))
+    return ::operator new(size);
+  return event_pool().allocate();
+}
+
+
+void timer_event::operator delete(void *p, size_t size)
+{
+  if (size != sizeof(timer_event))
+    ::operator delete(p);
+  else
+    event_pool().deallocate(p);
+}
+
+
+static void link_event(struct timer_event *ev, struct timer_event **slot)
+{
+  ev->slot = slot;
+  ev->prev = nullptr;
+  ev->next = *slot;
+  if (*slot)
+    (*slot)->prev = ev;
+  *slot = ev;
+}
+
+
+static void unlink_event(struct timer_event *ev)
+{
+  if (ev->prev)
+    ev->prev->next = ev->next;
+  else
+    *ev->slot = ev->next;
+  if (ev->next)
+    ev->next->prev = ev->prev;
+  ev->slot = nullptr;
+}
+
+
+/* File an event in the coarsest wheel whose slots are fine enough for it. */
+static void place_event(struct timer_event *ev)
+{
+  unsigned long ahead = ev->when - next_pulse;
+  int w;
+
+  if (ahead < ROOT_SIZE) {
+    link_event(ev, &root[ev->when & (ROOT_SIZE - 1)]);
+    return;
+  }
+
+  for (w = 0; w < WHEELS - 1; w++)
+    if (ahead < (1UL << (ROOT_BITS + (w + 1) * WHEEL_BITS)))
+      break;
+
+  link_event(ev, &wheels[w][(ev->when >> (ROOT_BITS + w * WHEEL_BITS)) & (WHEEL_SIZE - 1)]);
+}
+
+
+/* Move everything in one slot of wheel w down to where it now belongs. */
+static int cascade(int w)
+{
+  int index = (next_pulse >> (ROOT_BITS + w * WHEEL_BITS)) & (WHEEL_SIZE - 1);
+  struct timer_event *ev = wheels[w][index];
+
+  wheels[w][index] = nullptr;
+  while (ev) {
+    struct timer_event *next = ev->next;
+
+    place_event(ev);
+    ev = next;
+  }
+
+  return (index);
+}
+
+
+struct timer_event *add_timer(long delay, timer_func func)
+{
+  struct timer_event *ev = new timer_event;
+
+  delay = std::max(1L, delay);
+  ev->when = next_pulse + std::min(static_cast<unsigned long>(delay), MAX_DELAY) - 1;
+  ev->cancelled = false;
+  ev->func = std::move(func);
+  place_event(ev);
+  pending++;
+
+  return (ev);
+}
+
+
+void cancel_timer(struct timer_event *&ev)
+{
+  if (!ev)
+    return;
+
+  if (ev == running)
+    ev->cancelled = true;	/* run_timers() will let it go */
+  else {
+    unlink_event(ev);
+    delete ev;
+    pending--;
+  }
+  ev = nullptr;
+}
+
+
+/* One pulse: run whatever is due now, and bring the next ones closer. */
+void run_timers(void)
+{
+  int index = next_pulse & (ROOT_SIZE - 1);
+
+  if (!index)
+    for (int w = 0; w < WHEELS && !cascade(w); w++)
+      ;
+
+  /* Anything scheduled while these run is for a later pulse. */
+  next_pulse++;
+
+  due = root[index];
+  root[index] = nullptr;
+  for (struct timer_event *ev = due; ev; ev = ev->next)
+    ev->slot = &due;
+
+  while (due) {
+    struct timer_event *ev = due;
+    long again;
+
+    unlink_event(ev);
+    running = ev;
+    again = ev->func();
+    running = nullptr;
+
+    if (ev->cancelled || again <= 0) {
+      delete ev;
+      pending--;
+    } else {
+      ev->when = next_pulse + std::min(static_cast<unsigned long>(again), MAX_DELAY) - 1;
+      place_event(ev);
+    }
+  }
+}
+
+
+size_t timers_pending(void)
+{
+  return (pending);
+}
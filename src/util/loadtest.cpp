@@ -0,0 +1,617 @@
+/* ************************************************************************
+*  file:  loadtest.c                                  Part of CircleMUD   *
+*  Usage: drive a local server with simulated players and time it         *
+*  All Rights Reserved                                                    *
+************************************************************************* */
+
+/*
+ * Opens a number of telnet connections to a server on this machine, logs
+ * each one in through the usual nanny() dialogue (making the character
+ * the first time), and then has it play: walk, look, chat, fight, read
+ * paged help and so on, in a mix given on the command line, with some
+ * thinking time between commands.  Every command is timed from sending
+ * it to getting the prompt back.  At the end it prints latency
+ * percentiles per kind of command and the overall throughput.
+ *
+ * Given an immortal with -a, it also reads 'show stats' before and after,
+ * and reports how many game loop passes overran their pulse meanwhile.
+ *
+ * Everything runs in one thread over poll(); one loadtest process can
+ * keep several hundred clients going.  It only ever connects to
+ * 127.0.0.1.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define DFLT_PORT	4000
+#define DFLT_CLIENTS	50
+#define DFLT_SECONDS	60
+#define DFLT_THINK	1000	/* ms between commands, on average	*/
+#define DFLT_RAMP	20	/* new connections a second		*/
+#define DFLT_MIX	"walk=30,look=20,info=15,chat=10,fight=10,pager=5"
+
+#define NAME_PREFIX	"Sim"
+#define PASSWORD	"loadtest"
+#define TIMEOUT		10.0	/* seconds to wait for a prompt		*/
+
+/* What a client does; the mix gives each a weight. */
+enum { CMD_WALK, CMD_LOOK, CMD_INFO, CMD_CHAT, CMD_FIGHT, CMD_PAGER, NUM_CMDS };
+
+const char *cmd_names[NUM_CMDS] = { "walk", "look", "info", "chat", "fight", "pager" };
+
+const char *walk_cmds[] = { "north", "south", "east", "west", "up", "down", NULL };
+const char *look_cmds[] = { "look", "exits", NULL };
+const char *info_cmds[] = { "score", "who", "inventory", "equipment", "time", "weather", NULL };
+const char *chat_cmds[] = { "say Anyone seen the mayor?", "gossip Looking for a group.",
+	"say Nice weather today.", "gossip Where can I buy a lantern?", NULL };
+const char *fight_cmds[] = { "kill fido", "kill beggar", "kill cat", "kill drunk",
+	"kill janitor", "kill rat", NULL };
+const char *pager_cmds[] = { "help", "help socials", "news", NULL };
+
+const char **cmd_lists[NUM_CMDS] = { walk_cmds, look_cmds, info_cmds, chat_cmds, fight_cmds, pager_cmds };
+
+enum { CL_IDLE, CL_CONNECTING, CL_LOGIN, CL_PLAYING, CL_DEAD };
+
+struct client {
+  int fd;
+  int state;
+  int number;			/* which name we are trying		*/
+  int admin;			/* the -a immortal, reading stats	*/
+  std::string name, password;
+  std::string input;		/* received since we last answered	*/
+  int pending;			/* command awaiting its prompt, or -1	*/
+  double sent;			/* when it went out			*/
+  double next;			/* when to send the next one		*/
+  double started;		/* when we began connecting		*/
+};
+
+std::vector<struct client> clients;
+std::vector<double> latency[NUM_CMDS], logins;
+int mix[NUM_CMDS], mix_total = 0;
+int port = DFLT_PORT, think = DFLT_THINK, ramp = DFLT_RAMP;
+int next_number = 0;
+size_t started = 0, allowed = 0;	/* clients set going, and allowed to be */
+double ramp_begun;
+long timeouts = 0, disconnects = 0, failed = 0;
+unsigned long long bytes_in = 0;
+std::string stats_text;		/* what 'show stats' said, once it says it */
+
+
+double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+/* A name of letters only, as _parse_name() wants: Sim, then base 26. */
+std::string client_name(int number)
+{
+  std::string name = NAME_PREFIX;
+  char suffix[8];
+  int i = 0;
+
+  do {
+    suffix[i++] = 'a' + number % 26;
+    number /= 26;
+  } while (number && i < 7);
+
+  while (i > 0)
+    name += suffix[--i];
+  return (name);
+}
+
+
+void usage(void)
+{
+  fprintf(stderr,
+	"Usage: loadtest [-p port] [-n clients] [-t seconds] [-w think_ms]\n"
+	"                [-r connects_per_sec] [-m mix] [-a name:password]\n"
+	"  mix is kind=weight,... from walk, look, info, chat, fight, pager;\n"
+	"  default %s\n", DFLT_MIX);
+  exit(1);
+}
+
+
+void parse_mix(const char *arg)
+{
+  char buf[256], *item;
+  int i;
+
+  strncpy(buf, arg, sizeof(buf) - 1);	/* strncpy: OK (buf:256) */
+  buf[sizeof(buf) - 1] = '\0';
+  memset(mix, 0, sizeof(mix));
+  mix_total = 0;
+
+  for (item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+    char *eq = strchr(item, '=');
+
+    if (!eq)
+      usage();
+    *eq = '\0';
+    for (i = 0; i < NUM_CMDS; i++)
+      if (!strcmp(item, cmd_names[i]))
+	break;
+    if (i == NUM_CMDS) {
+      fprintf(stderr, "loadtest: unknown command kind '%s'\n", item);
+      usage();
+    }
+    mix[i] = atoi(eq + 1);
+    mix_total += mix[i];
+  }
+
+  if (mix_total <= 0)
+    usage();
+}
+
+
+void start_client(struct client &c)
+{
+  struct sockaddr_in sa;
+
+  c.input.clear();
+  c.pending = -1;
+  c.started = now();
+
+  if ((c.fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+    perror("loadtest: socket");
+    exit(1);
+  }
+  fcntl(c.fd, F_SETFL, O_NONBLOCK);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (connect(c.fd, (struct sockaddr *) &sa, sizeof(sa)) < 0 && errno != EINPROGRESS) {
+    perror("loadtest: connect");
+    close(c.fd);
+    c.fd = -1;
+    c.state = CL_DEAD;
+    failed++;
+    return;
+  }
+  c.state = CL_CONNECTING;
+}
+
+
+void drop_client(struct client &c, const char *why)
+{
+  if (c.fd >= 0)
+    close(c.fd);
+  c.fd = -1;
+
+  if (c.state == CL_PLAYING)
+    disconnects++;
+  else
+    failed++;
+  if (why)
+    fprintf(stderr, "loadtest: %s: %s\n", c.name.c_str(), why);
+  c.state = CL_DEAD;
+}
+
+
+void send_line(struct client &c, const char *txt)
+{
+  std::string line = std::string(txt) + "\r\n";
+
+  /* A line is tiny; if the socket will not take it, the server is stuck. */
+  if (send(c.fd, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t) line.size())
+    drop_client(c, "send failed");
+  c.input.clear();
+}
+
+
+/* Pick the next command from the mix and send it. */
+void send_command(struct client &c)
+{
+  const char **list;
+  int roll = rand() % mix_total, kind, n;
+
+  for (kind = 0; roll >= mix[kind]; kind++)
+    roll -= mix[kind];
+
+  list = cmd_lists[kind];
+  for (n = 0; list[n]; n++)
+    ;
+
+  c.pending = kind;
+  c.sent = now();
+  send_line(c, list[rand() % n]);
+}
+
+
+/* Takes the telnet commands the server sends (ECHO, COMPRESS2) back out. */
+void strip_telnet(std::string &txt)
+{
+  size_t i = 0;
+
+  while ((i = txt.find('\xff', i)) != std::string::npos)
+    txt.erase(i, std::min<size_t>(3, txt.size() - i));
+}
+
+
+bool ends_with(const std::string &txt, const char *tail)
+{
+  size_t len = strlen(tail);
+
+  return (txt.size() >= len && txt.compare(txt.size() - len, len, tail) == 0);
+}
+
+
+bool ends_with(const std::string &txt, const std::string &tail)
+{
+  return ends_with(txt, tail.c_str());
+}
+
+
+/* Answers whatever nanny() just asked. */
+void answer_login(struct client &c)
+{
+  const std::string &in = c.input;
+
+  if (in.find("Invalid name") != std::string::npos) {
+    /* One of lib/misc/xnames is in it; move on to another name. */
+    c.number = next_number++;
+    c.name = client_name(c.number);
+    send_line(c, c.name.c_str());
+  } else if (in.find("By what name") != std::string::npos)
+    send_line(c, c.name.c_str());
+  else if (in.find("Did I get that right") != std::string::npos) {
+    if (c.admin)
+      drop_client(c, "no such character");
+    else
+      send_line(c, "y");
+  }
+  else if (in.find("Wrong password") != std::string::npos)
+    drop_client(c, "wrong password (made by an earlier run with another password?)");
+  else if (ends_with(in, "Password: ") || ends_with(in, "password for " + c.name + ": ") ||
+	   ends_with(in, "retype password: "))
+    send_line(c, c.password.c_str());
+  else if (ends_with(in, "(M/F)? "))
+    send_line(c, "m");
+  else if (ends_with(in, "Class: "))
+    send_line(c, "w");
+  else if (ends_with(in, "PRESS RETURN: "))
+    send_line(c, "");
+  else if (ends_with(in, "Make your choice: "))
+    send_line(c, "1");
+  else if (ends_with(in, "> ")) {
+    c.state = CL_PLAYING;
+    if (!c.admin)
+      logins.push_back(now() - c.started);
+    c.next = now() + (rand() % (think + 1)) / 1000.0;
+    c.input.clear();
+  }
+}
+
+
+/* Output has come in for a client that is playing. */
+void answer_game(struct client &c)
+{
+  double t = now();
+
+  if (ends_with(c.input, "Make your choice: ")) {
+    /* Died, most likely; back into the game. */
+    send_line(c, "1");
+    c.pending = -1;
+    return;
+  }
+
+  if (c.pending < 0) {
+    c.input.clear();	/* someone else's doing: a gossip, a fight */
+    return;
+  }
+
+  if (ends_with(c.input, "]") && c.input.find("or page number (") != std::string::npos) {
+    latency[c.pending].push_back(t - c.sent);
+    c.sent = t;
+    send_line(c, "");		/* next page, timed as a pager command */
+    return;
+  }
+
+  if (!ends_with(c.input, "> "))
+    return;
+
+  if (c.admin)
+    stats_text = c.input;
+  else
+    latency[c.pending].push_back(t - c.sent);
+  c.pending = -1;
+  c.input.clear();
+  c.next = t + (think / 2 + rand() % (think + 1)) / 1000.0;
+}
+
+
+void read_client(struct client &c)
+{
+  char buf[16384];
+  ssize_t n;
+
+  while ((n = recv(c.fd, buf, sizeof(buf), 0)) > 0) {
+    bytes_in += n;
+    c.input.append(buf, n);
+  }
+
+  if (n == 0) {
+    drop_client(c, c.state == CL_PLAYING ? "server closed the connection" : "closed during login");
+    return;
+  }
+  if (errno != EAGAIN && errno != EWOULDBLOCK) {
+    drop_client(c, strerror(errno));
+    return;
+  }
+
+  strip_telnet(c.input);
+
+  if (c.state == CL_LOGIN)
+    answer_login(c);
+  else if (c.state == CL_PLAYING)
+    answer_game(c);
+}
+
+
+/*
+ * Runs everyone until 'until', or until done() says so, connecting up to
+ * 'ramp' new clients a second while there are 'allowed' ones left.
+ */
+void run_clients(double until, bool (*done)(void))
+{
+  std::vector<struct pollfd> pfds;
+  std::vector<size_t> which;
+
+  while (now() < until && !(done && done())) {
+    double t = now();
+
+    while (started < allowed && (ramp <= 0 || started < (t - ramp_begun) * ramp + 1)) {
+      if (clients[started].state == CL_IDLE)
+	start_client(clients[started]);
+      started++;
+    }
+
+    pfds.clear();
+    which.clear();
+    for (size_t i = 0; i < clients.size(); i++) {
+      struct client &c = clients[i];
+
+      if (c.fd < 0)
+	continue;
+
+      if (c.state == CL_PLAYING && c.pending < 0 && !c.admin && t >= c.next)
+	send_command(c);
+      else if (c.pending >= 0 && t - c.sent > TIMEOUT) {
+	timeouts++;
+	c.pending = -1;
+	c.input.clear();
+      } else if (c.state == CL_LOGIN && t - c.started > 5 * TIMEOUT)
+	drop_client(c, "login timed out");
+
+      if (c.fd < 0)
+	continue;
+      pfds.push_back({ c.fd, (short) (c.state == CL_CONNECTING ? POLLOUT : POLLIN), 0 });
+      which.push_back(i);
+    }
+
+    if (poll(pfds.data(), pfds.size(), 10) < 0 && errno != EINTR) {
+      perror("loadtest: poll");
+      exit(1);
+    }
+
+    for (size_t k = 0; k < pfds.size(); k++) {
+      struct client &c = clients[which[k]];
+
+      if (!pfds[k].revents || c.fd < 0)
+	continue;
+
+      if (c.state == CL_CONNECTING) {
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+	if (err)
+	  drop_client(c, strerror(err));
+	else
+	  c.state = CL_LOGIN;
+	continue;
+      }
+      read_client(c);
+    }
+  }
+}
+
+
+bool admin_ready(void)
+{
+  return (clients[0].state != CL_CONNECTING && clients[0].state != CL_LOGIN);
+}
+
+
+bool all_logged_in(void)
+{
+  for (const struct client &c : clients)
+    if (c.state == CL_IDLE || c.state == CL_CONNECTING || c.state == CL_LOGIN)
+      return (false);
+  return (true);
+}
+
+
+bool stats_read(void)
+{
+  return (!stats_text.empty());
+}
+
+
+/* Asks the admin for 'show stats' and waits for it. */
+std::string read_stats(struct client &admin)
+{
+  if (admin.state != CL_PLAYING)
+    return ("");
+
+  stats_text.clear();
+  admin.pending = CMD_INFO;
+  admin.sent = now();
+  send_line(admin, "show stats");
+  run_clients(now() + TIMEOUT, stats_read);
+  admin.pending = -1;
+
+  return (stats_text);
+}
+
+
+bool parse_loop_stats(const std::string &txt, unsigned long &passes, unsigned long &overruns, long &longest)
+{
+  size_t at = txt.find("Game loop:");
+
+  if (at == std::string::npos)
+    return (false);
+  return (sscanf(txt.c_str() + at, "Game loop: %lu passes, %lu overran %*d ms, longest %ld ms",
+	&passes, &overruns, &longest) == 3);
+}
+
+
+double percentile(const std::vector<double> &v, double p)
+{
+  if (v.empty())
+    return (0);
+  return (v[std::min(v.size() - 1, (size_t) (p * v.size()))]);
+}
+
+
+void print_row(const char *name, std::vector<double> &v)
+{
+  std::sort(v.begin(), v.end());
+  printf("  %-8s %7zu %8.1f %8.1f %8.1f %8.1f\n", name, v.size(),
+	percentile(v, 0.5) * 1000, percentile(v, 0.9) * 1000,
+	percentile(v, 0.99) * 1000, (v.empty() ? 0 : v.back()) * 1000);
+}
+
+
+int main(int argc, char **argv)
+{
+  int nclients = DFLT_CLIENTS, seconds = DFLT_SECONDS, i;
+  unsigned long passes[2] = { 0, 0 }, overruns[2] = { 0, 0 };
+  long longest[2] = { 0, 0 };
+  bool have_stats = false;
+  std::string admin;
+  size_t playing;
+  double start;
+
+  parse_mix(DFLT_MIX);
+
+  for (i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || !argv[i][1] || argv[i][2] || i + 1 >= argc)
+      usage();
+    switch (argv[i][1]) {
+    case 'p': port = atoi(argv[++i]); break;
+    case 'n': nclients = atoi(argv[++i]); break;
+    case 't': seconds = atoi(argv[++i]); break;
+    case 'w': think = atoi(argv[++i]); break;
+    case 'r': ramp = atoi(argv[++i]); break;
+    case 'm': parse_mix(argv[++i]); break;
+    case 'a': admin = argv[++i]; break;
+    default: usage();
+    }
+  }
+  if (port <= 0 || nclients <= 0 || seconds <= 0 || think < 0)
+    usage();
+
+  srand(getpid());
+
+  /* The admin, if any, goes first so it sees the whole run. */
+  if (!admin.empty()) {
+    size_t colon = admin.find(':');
+
+    if (colon == std::string::npos)
+      usage();
+    clients.push_back(client());
+    clients.back().name = admin.substr(0, colon);
+    clients.back().password = admin.substr(colon + 1);
+    clients.back().admin = 1;
+  }
+  for (i = 0; i < nclients; i++) {
+    clients.push_back(client());
+    clients.back().number = next_number++;
+    clients.back().name = client_name(clients.back().number);
+    clients.back().password = PASSWORD;
+    clients.back().admin = 0;
+  }
+  for (struct client &c : clients) {
+    c.fd = -1;
+    c.state = CL_IDLE;
+    c.pending = -1;
+  }
+
+  printf("loadtest: %d clients against 127.0.0.1:%d for %d s, %d ms think time\n",
+	nclients, port, seconds, think);
+
+  ramp_begun = now();
+  if (!admin.empty()) {
+    allowed = 1;
+    run_clients(now() + 5 * TIMEOUT, admin_ready);
+  }
+
+  /* Let everyone log in, then measure for the time asked. */
+  allowed = clients.size();
+  ramp_begun = now();
+  run_clients(now() + 5 * TIMEOUT + (double) nclients / std::max(ramp, 1), all_logged_in);
+  for (i = 0; i < NUM_CMDS; i++)
+    latency[i].clear();
+  bytes_in = 0;
+  timeouts = 0;
+
+  if (!admin.empty())
+    have_stats = parse_loop_stats(read_stats(clients[0]), passes[0], overruns[0], longest[0]);
+
+  start = now();
+  run_clients(start + seconds, NULL);
+  double elapsed = now() - start;
+
+  if (have_stats)
+    have_stats = parse_loop_stats(read_stats(clients[0]), passes[1], overruns[1], longest[1]);
+
+  playing = std::count_if(clients.begin(), clients.end(),
+	[](const struct client &c) { return (c.state == CL_PLAYING && !c.admin); });
+
+  size_t total = 0;
+  for (i = 0; i < NUM_CMDS; i++)
+    total += latency[i].size();
+
+  printf("\n%zu of %d clients playing at the end; %ld failed to log in, %ld dropped\n",
+	playing, nclients, failed, disconnects);
+  printf("%zu commands in %.1f s: %.1f a second; %.1f KB/s received; %ld timed out\n\n",
+	total, elapsed, total / elapsed, bytes_in / 1024.0 / elapsed, timeouts);
+
+  printf("  %-8s %7s %8s %8s %8s %8s   (ms, send to prompt)\n", "command", "count", "p50", "p90", "p99", "max");
+  print_row("login", logins);
+  for (i = 0; i < NUM_CMDS; i++)
+    if (mix[i])
+      print_row(cmd_names[i], latency[i]);
+
+  if (have_stats) {
+    unsigned long p = passes[1] - passes[0], o = overruns[1] - overruns[0];
+
+    printf("\nserver: %lu game loop passes, %lu overran (%.2f%%); longest pass so far %ld ms\n",
+	p, o, p ? 100.0 * o / p : 0.0, longest[1]);
+  } else if (!admin.empty())
+    printf("\nserver: could not read 'show stats' as %s\n", clients[0].name.c_str());
+
+  for (struct client &c : clients)
+    if (c.fd >= 0)
+      close(c.fd);
+
+  return (0);
+}
@@ -11,6 +11,7 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#include <mutex>
 
 #include "structs.h"
 #include "utils.h"
@@ -201,6 +202,9 @@ void log_death_trap(struct char_data *ch)
  */
 void basic_mud_vlog(const char *format, va_list args)
 {
+  /* The world loaders log from several threads at once during boot. */
+  static std::mutex log_lock;
+  std::lock_guard<std::mutex> guard(log_lock);
   time_t ct = time(0);
   char *time_s = asctime(localtime(&ct));
 